@@ -3,6 +3,9 @@
 
 #include "ActivateCollisionNotifyState.h"
 #include "Components/SkeletalMeshComponent.h"
+#include "Animation/AnimInstance.h"
+#include "Animation/AnimMontage.h"
+#include "StarterBundleStats.h"
 
 UActivateCollisionNotifyState::UActivateCollisionNotifyState()
 	: CollisionPart(ECollisionPart::PrimaryItem)
@@ -12,16 +15,31 @@ UActivateCollisionNotifyState::UActivateCollisionNotifyState()
 
 void UActivateCollisionNotifyState::NotifyBegin(USkeletalMeshComponent * MeshComp, UAnimSequenceBase * Animation, float TotalDuration)
 {
+	STARTERBUNDLE_SCOPE_CYCLE_COUNTER(STAT_AnimNotifyDispatch);
+
 	if (MeshComp)
 	{
 		AActor* Owner = MeshComp->GetOwner();
 
 		if (Owner)
 		{
-			UCollisionHandlerComponent* CollisionHandlerComponent = Cast<UCollisionHandlerComponent>(Owner->GetComponentByClass(UCollisionHandlerComponent::StaticClass()));
+			UCollisionHandlerComponent* CollisionHandlerComponent = UCollisionHandlerComponent::FindCollisionHandler(Owner);
 
 			if (CollisionHandlerComponent)
 			{
+				// baked trajectories of this montage are used instead of pose if handler allows it
+				CollisionHandlerComponent->SetTrajectorySource(MeshComp, Animation);
+				// duration of notify is in montage time, handler compares it against world time
+				float PlayRate = MeshComp->GlobalAnimRateScale;
+				const UAnimInstance* AnimInstance = MeshComp->GetAnimInstance();
+				const FAnimMontageInstance* MontageInstance = AnimInstance ? AnimInstance->GetActiveInstanceForMontage(Cast<UAnimMontage>(Animation)) : nullptr;
+				if (MontageInstance)
+				{
+					PlayRate *= FMath::Abs(MontageInstance->GetPlayRate());
+				}
+
+				// stopped montage has no expected end, so activation is treated as one of unknown length
+				CollisionHandlerComponent->SetActivationDuration(PlayRate > KINDA_SMALL_NUMBER ? TotalDuration / PlayRate : 0.f);
 				CollisionHandlerComponent->ActivateCollision(CollisionPart);
 			}
 		}
@@ -30,17 +48,19 @@ void UActivateCollisionNotifyState::NotifyBegin(USkeletalMeshComponent * MeshCom
 
 void UActivateCollisionNotifyState::NotifyEnd(USkeletalMeshComponent * MeshComp, UAnimSequenceBase * Animation)
 {
+	STARTERBUNDLE_SCOPE_CYCLE_COUNTER(STAT_AnimNotifyDispatch);
+
 	if (MeshComp)
 	{
 		AActor* Owner = MeshComp->GetOwner();
 
 		if (Owner)
 		{
-			UCollisionHandlerComponent* CollisionHandlerComponent = Cast<UCollisionHandlerComponent>(Owner->GetComponentByClass(UCollisionHandlerComponent::StaticClass()));
+			UCollisionHandlerComponent* CollisionHandlerComponent = UCollisionHandlerComponent::FindCollisionHandler(Owner);
 			
 			if (CollisionHandlerComponent)
 			{
-				CollisionHandlerComponent->DeactivateCollision();
+				CollisionHandlerComponent->DeactivateCollisionPart(CollisionPart);
 			}
 		}
 	}
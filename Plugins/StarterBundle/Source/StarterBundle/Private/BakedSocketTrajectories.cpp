@@ -0,0 +1,173 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "BakedSocketTrajectories.h"
+#include "Animation/AnimSequenceBase.h"
+#include "Animation/AnimMontage.h"
+
+#if WITH_EDITOR
+#include "ActivateCollisionNotifyState.h"
+#include "BonePose.h"
+#include "Engine/SkeletalMesh.h"
+#include "Engine/SkeletalMeshSocket.h"
+#include "Misc/MemStack.h"
+#endif
+
+FVector FBakedSocketTrajectoryWindow::Sample(int32 SocketIndex, float Time) const
+{
+	const int32 NumSockets = Sockets.Num();
+	const int32 NumSamples = GetNumSamples();
+	if (NumSamples == 1 || SampleInterval <= 0.f)
+	{
+		return Locations[SocketIndex];
+	}
+
+	const float SamplePosition = FMath::Clamp((Time - StartTime) / SampleInterval, 0.f, float(NumSamples - 1));
+	const int32 Sample1 = FMath::Min(FMath::FloorToInt(SamplePosition), NumSamples - 2);
+	const float Alpha = SamplePosition - Sample1;
+
+	// neighbours are clamped at window ends, tangents are per sample so spline passes through every baked location
+	const FVector& P0 = Locations[FMath::Max(Sample1 - 1, 0) * NumSockets + SocketIndex];
+	const FVector& P1 = Locations[Sample1 * NumSockets + SocketIndex];
+	const FVector& P2 = Locations[(Sample1 + 1) * NumSockets + SocketIndex];
+	const FVector& P3 = Locations[FMath::Min(Sample1 + 2, NumSamples - 1) * NumSockets + SocketIndex];
+
+	return FMath::CubicInterp(P1, (P2 - P0) * 0.5f, P2, (P3 - P1) * 0.5f, Alpha);
+}
+
+int32 UBakedSocketTrajectories::FindWindow(float Time) const
+{
+	for (int32 Index = 0; Index < Windows.Num(); ++Index)
+	{
+		if (Windows[Index].ContainsTime(Time))
+		{
+			return Index;
+		}
+	}
+	return INDEX_NONE;
+}
+
+UBakedSocketTrajectories* UBakedSocketTrajectories::Get(const UAnimSequenceBase* Animation)
+{
+	// asset user data interface isn't const, lookup doesn't modify the asset
+	UAnimSequenceBase* MutableAnimation = const_cast<UAnimSequenceBase*>(Animation);
+	return MutableAnimation ? Cast<UBakedSocketTrajectories>(MutableAnimation->GetAssetUserDataOfClass(UBakedSocketTrajectories::StaticClass())) : nullptr;
+}
+
+#if WITH_EDITOR
+UBakedSocketTrajectories* UBakedSocketTrajectories::Bake(UAnimMontage* Montage, USkeletalMesh* Mesh, const TArray<FName>& Sockets, float SampleRate)
+{
+	if (Montage == nullptr || Mesh == nullptr || Montage->SlotAnimTracks.Num() == 0 || SampleRate <= 0.f)
+	{
+		return nullptr;
+	}
+
+	// sockets are resolved to bone and offset once, names that are neither socket nor bone are skipped
+	const FReferenceSkeleton& RefSkeleton = Mesh->RefSkeleton;
+	TArray<FName> BakedSockets;
+	TArray<int32> SocketBones;
+	TArray<FTransform> SocketOffsets;
+	for (const FName& SocketName : Sockets)
+	{
+		const USkeletalMeshSocket* Socket = Mesh->FindSocket(SocketName);
+		const int32 BoneIndex = RefSkeleton.FindBoneIndex(Socket ? Socket->BoneName : SocketName);
+		if (BoneIndex != INDEX_NONE)
+		{
+			BakedSockets.Add(SocketName);
+			SocketBones.Add(BoneIndex);
+			SocketOffsets.Add(Socket ? Socket->GetSocketLocalTransform() : FTransform::Identity);
+		}
+	}
+
+	TArray<FBakedSocketTrajectoryWindow> Windows;
+	for (const FAnimNotifyEvent& NotifyEvent : Montage->Notifies)
+	{
+		if (Cast<UActivateCollisionNotifyState>(NotifyEvent.NotifyStateClass))
+		{
+			FBakedSocketTrajectoryWindow& Window = Windows[Windows.AddDefaulted()];
+			Window.StartTime = FMath::Clamp(NotifyEvent.GetTriggerTime(), 0.f, Montage->SequenceLength);
+			Window.EndTime = FMath::Clamp(NotifyEvent.GetEndTriggerTime(), Window.StartTime, Montage->SequenceLength);
+			Window.Sockets = BakedSockets;
+		}
+	}
+
+	if (Windows.Num() == 0 || BakedSockets.Num() == 0)
+	{
+		return nullptr;
+	}
+
+	Windows.Sort([](const FBakedSocketTrajectoryWindow& A, const FBakedSocketTrajectoryWindow& B) { return A.StartTime < B.StartTime; });
+
+	// whole skeleton is required, so compact pose indices match mesh bone indices
+	FMemMark Mark(FMemStack::Get());
+	TArray<FBoneIndexType> RequiredBones;
+	RequiredBones.SetNumUninitialized(RefSkeleton.GetNum());
+	for (int32 BoneIndex = 0; BoneIndex < RequiredBones.Num(); ++BoneIndex)
+	{
+		RequiredBones[BoneIndex] = (FBoneIndexType)BoneIndex;
+	}
+	FBoneContainer BoneContainer(RequiredBones, FCurveEvaluationOption(false), *Mesh);
+
+	FCompactPose Pose;
+	Pose.SetBoneContainer(&BoneContainer);
+	FBlendedCurve Curve;
+	Curve.InitFrom(BoneContainer);
+	FCSPose<FCompactPose> ComponentSpacePose;
+
+	// montages are baked from their first slot, the same slot that is played on the mesh
+	const FAnimTrack& AnimTrack = Montage->SlotAnimTracks[0].AnimTrack;
+
+	for (FBakedSocketTrajectoryWindow& Window : Windows)
+	{
+		const float Duration = Window.EndTime - Window.StartTime;
+		const int32 NumSamples = FMath::CeilToInt(Duration * SampleRate) + 1;
+		Window.SampleInterval = NumSamples > 1 ? Duration / (NumSamples - 1) : 0.f;
+		Window.Locations.Reserve(NumSamples * BakedSockets.Num());
+
+		for (int32 SampleIndex = 0; SampleIndex < NumSamples; ++SampleIndex)
+		{
+			const float Time = Window.StartTime + Window.SampleInterval * SampleIndex;
+
+			float AnimationTime = 0.f;
+			float Weight = 0.f;
+			const FAnimSegment* Segment = AnimTrack.GetSegmentAtTime(Time);
+			UAnimSequenceBase* Animation = Segment ? Segment->GetAnimationData(Time, AnimationTime, Weight) : nullptr;
+
+			if (Animation)
+			{
+				Animation->GetAnimationPose(Pose, Curve, FAnimExtractContext(AnimationTime, false));
+			}
+			else
+			{
+				Pose.ResetToRefPose();
+			}
+
+			// root motion is taken by character movement at runtime and root bone stays locked in reference pose
+			if (Montage->HasRootMotion())
+			{
+				const FCompactPoseBoneIndex RootIndex(0);
+				Pose[RootIndex] = Pose.GetRefPose(RootIndex);
+			}
+
+			ComponentSpacePose.InitPose(Pose);
+			for (int32 SocketIndex = 0; SocketIndex < BakedSockets.Num(); ++SocketIndex)
+			{
+				const FTransform& BoneTransform = ComponentSpacePose.GetComponentSpaceTransform(FCompactPoseBoneIndex(SocketBones[SocketIndex]));
+				Window.Locations.Add(BoneTransform.TransformPosition(SocketOffsets[SocketIndex].GetLocation()));
+			}
+		}
+	}
+
+	UBakedSocketTrajectories* Trajectories = Get(Montage);
+	if (Trajectories == nullptr)
+	{
+		Montage->Modify();
+		Trajectories = NewObject<UBakedSocketTrajectories>(Montage, NAME_None, RF_Transactional);
+		Montage->AddAssetUserData(Trajectories);
+	}
+
+	Trajectories->Modify();
+	Trajectories->Windows = MoveTemp(Windows);
+	return Trajectories;
+}
+#endif
@@ -2,36 +2,243 @@
 
 
 #include "CollisionHandlerComponent.h"
+#include "CollisionHandlerSubsystem.h"
+#include "HurtboxComponent.h"
+#include "HurtboxCapsuleSet.h"
+#include "BakedSocketTrajectories.h"
+#include "StarterBundleStats.h"
 #include "Components/PrimitiveComponent.h"
-#include "Kismet/KismetSystemLibrary.h"
+#include "Components/SkinnedMeshComponent.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Components/StaticMeshComponent.h"
+#include "Components/CapsuleComponent.h"
+#include "Engine/SkeletalMesh.h"
+#include "Engine/SkeletalMeshSocket.h"
+#include "Engine/StaticMesh.h"
+#include "Engine/StaticMeshSocket.h"
+#include "Animation/AnimInstance.h"
+#include "Animation/AnimMontage.h"
 #include "TimerManager.h"
+#include "Engine/World.h"
+#include "GameFramework/Actor.h"
+#include "GameFramework/Pawn.h"
+#include "DrawDebugHelpers.h"
+
+namespace CollisionHandlerCapture
+{
+	/* Distance from sockets in which hurtboxes are captured with trajectory samples */
+	static const float TargetMargin = 100.f;
+}
+
+namespace CollisionHandlerLookup
+{
+	/* Registered handlers keyed by owner, used by anim notifies to avoid scanning owner components */
+	static TMap<FObjectKey, TWeakObjectPtr<UCollisionHandlerComponent>> HandlersByOwner;
+}
 
 // Sets default values for this component's properties
 UCollisionHandlerComponent::UCollisionHandlerComponent()
 	: TraceRadius(0.1f),
-	TraceCheckInterval(0.025f)
+	TraceCheckInterval(0.025f),
+	bUseBatchedTraceCheck(true),
+	bSampleOnPoseUpdate(false),
+	bUseAsyncTrace(false),
+	bUseHurtboxNarrowphase(false),
+	bUseHurtboxBroadphase(false),
+	bInterpolateSocketArc(false),
+	ArcSubsteps(3),
+	bUseAdaptiveTraceInterval(false),
+	MaxTraceDistanceError(2.f),
+	MinTraceCheckInterval(1.f / 120.f),
+	MaxTraceCheckInterval(0.1f),
+	MaxAdaptiveArcSubsteps(8),
+	bUseBakedTrajectories(false),
+	TraceShape(ECollisionTraceShape::SocketSpheres),
+	MaxBladeSweepAngle(30.f),
+	IgnoreRulesPrefilterReach(300.f),
+	bUseFidelityTiers(false),
+	bRecordHistory(false),
+	HistoryDuration(0.5f),
+	HistorySampleInterval(1.f / 30.f),
+	HurtboxRadius(34.f),
+	HurtboxHalfHeight(88.f),
+	ValidationTolerance(10.f),
+	bCaptureTrajectory(false),
+	bDispatchHitsInBatches(false),
+	ActivePartMask(0),
+	ActiveStateMask(0),
+	ActivationId(0),
+	NumSweepsIssued(0),
+	CurrentTraceCheckInterval(0.f),
+	LastTraceCheckTime(-1.f),
+	LastStepInterval(0.f),
+	ArcIntervalRatio(1.f),
+	FidelityTierIndex(0),
+	Significance(1.f),
+	FidelityTierChangeTime(0.f),
+	NextSignificanceUpdateTime(0.f),
+	ActivationStartTime(0.f),
+	ActivationDuration(0.f),
+	PendingActivationDuration(0.f)
 {
-	// Set this component to be initialized when the game starts, and to be ticked every frame.  You can turn these features
-	// off to improve performance if you don't need them.
-	PrimaryComponentTick.bCanEverTick = false;
+	// Component ticks only to record history if bRecordHistory is set, trace checks are driven by subsystem or timer
+	PrimaryComponentTick.bCanEverTick = true;
+	PrimaryComponentTick.bStartWithTickEnabled = false;
 
 	// adds Pawn value to objects to collide with
 	ObjectTypesToCollideWith.Add(EObjectTypeQuery::ObjectTypeQuery3);
+
+	// one entry per collision part, so activation is only a lookup by part
+	CollisionParts.SetNum((int32)ECollisionPart::Custom3 + 1);
+	PartActivationCounts.SetNumZeroed(CollisionParts.Num());
+
+	// full, reduced, blade capsule only and midpoint overlap only
+	FidelityTiers.Add(FCollisionFidelityTier(0.6f, 1.f, 0, false, false));
+	FidelityTiers.Add(FCollisionFidelityTier(0.3f, 2.f, 2, false, false));
+	FidelityTiers.Add(FCollisionFidelityTier(0.1f, 4.f, 2, true, false));
+	FidelityTiers.Add(FCollisionFidelityTier(0.f, 1.f, 0, false, true));
+
+	AsyncTraceDelegate.BindUObject(this, &UCollisionHandlerComponent::OnAsyncTraceCompleted);
 }
 
 // Called when the game starts
 void UCollisionHandlerComponent::BeginPlay()
 {
 	Super::BeginPlay();
+
+	if (bRecordHistory)
+	{
+		// hurtbox follows owner capsule if there is one
+		if (const UCapsuleComponent* Capsule = Cast<UCapsuleComponent>(GetOwner()->GetRootComponent()))
+		{
+			HurtboxRadius = Capsule->GetScaledCapsuleRadius();
+			HurtboxHalfHeight = Capsule->GetScaledCapsuleHalfHeight();
+		}
+
+		InitializeHistory();
+		SetComponentTickInterval(HistorySampleInterval);
+		SetComponentTickEnabled(true);
+	}
+}
+
+void UCollisionHandlerComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	// make sure neither timer nor subsystem keeps processing this component
+	StopTraceCheckLoop();
+
+	// hits of last frame are dropped, subsystem skips handlers without pending hits
+	PendingHits.Reset();
+
+	EndTrajectoryCapture();
+
+	DEC_MEMORY_STAT_BY(STAT_HitHistoryMemory, History.GetAllocatedSize());
+	History.Initialize(0, 0);
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void UCollisionHandlerComponent::OnRegister()
+{
+	Super::OnRegister();
+
+	// first registered handler is used, same as GetComponentByClass
+	if (AActor* Owner = GetOwner())
+	{
+		TWeakObjectPtr<UCollisionHandlerComponent>& Handler = CollisionHandlerLookup::HandlersByOwner.FindOrAdd(FObjectKey(Owner));
+		if (Handler.IsValid() == false)
+		{
+			Handler = this;
+		}
+	}
+}
+
+void UCollisionHandlerComponent::OnUnregister()
+{
+	if (AActor* Owner = GetOwner())
+	{
+		const FObjectKey OwnerKey(Owner);
+		const TWeakObjectPtr<UCollisionHandlerComponent>* Handler = CollisionHandlerLookup::HandlersByOwner.Find(OwnerKey);
+		if (Handler && (Handler->IsValid() == false || Handler->Get() == this))
+		{
+			CollisionHandlerLookup::HandlersByOwner.Remove(OwnerKey);
+
+			// owner may have another handler which should be used from now on
+			TInlineComponentArray<UCollisionHandlerComponent*> OwnerHandlers(Owner);
+			for (UCollisionHandlerComponent* OwnerHandler : OwnerHandlers)
+			{
+				if (OwnerHandler != this && OwnerHandler->IsRegistered())
+				{
+					CollisionHandlerLookup::HandlersByOwner.Add(OwnerKey, OwnerHandler);
+					break;
+				}
+			}
+		}
+	}
+
+	Super::OnUnregister();
+}
+
+UCollisionHandlerComponent* UCollisionHandlerComponent::FindCollisionHandler(const AActor* Actor)
+{
+	const TWeakObjectPtr<UCollisionHandlerComponent>* Handler = CollisionHandlerLookup::HandlersByOwner.Find(FObjectKey(Actor));
+	return Handler ? Handler->Get() : nullptr;
 }
 
 void UCollisionHandlerComponent::NotifyOnHit(const FHitResult& HitResult)
 {
+	STARTERBUNDLE_SCOPE_CYCLE_COUNTER(STAT_NotifyOnHit);
+	STARTERBUNDLE_INC_COUNTER(STAT_HitsDelivered, 1);
+
+	if (bDispatchHitsInBatches)
+	{
+		QueueHitForDispatch(HitResult);
+		return;
+	}
+
 	// Notify native before blueprint
 	OnHitNative.Broadcast(HitResult);
 	OnHit.Broadcast(HitResult);
 }
 
+void UCollisionHandlerComponent::QueueHitForDispatch(const FHitResult& HitResult)
+{
+	PendingHits.Add(HitResult);
+
+	if (bIsHitDispatchQueued == false)
+	{
+		UWorld* World = GetWorld();
+		UCollisionHandlerSubsystem* Subsystem = World ? World->GetSubsystem<UCollisionHandlerSubsystem>() : nullptr;
+		if (Subsystem == nullptr)
+		{
+			DispatchPendingHits();
+			return;
+		}
+
+		bIsHitDispatchQueued = true;
+		Subsystem->QueueHitDispatch(this);
+	}
+}
+
+void UCollisionHandlerComponent::DispatchPendingHits()
+{
+	bIsHitDispatchQueued = false;
+	if (PendingHits.Num() == 0)
+	{
+		return;
+	}
+
+	STARTERBUNDLE_SCOPE_CYCLE_COUNTER(STAT_NotifyOnHit);
+
+	// callbacks may end play of this component or queue new hits, broadcast array must not change under them
+	Exchange(PendingHits, DispatchingHits);
+
+	// Notify native before blueprint
+	OnHitBatchNative.Broadcast(DispatchingHits);
+	OnHitBatch.Broadcast(DispatchingHits);
+
+	DispatchingHits.Reset();
+}
+
 void UCollisionHandlerComponent::NotifyOnCollisionActivated(ECollisionPart CollisionPart)
 {
 	// Notify native before blueprint
@@ -46,129 +253,1700 @@ void UCollisionHandlerComponent::NotifyOnCollisionDeactivated()
 	OnCollisionDeactivated.Broadcast();
 }
 
-void UCollisionHandlerComponent::UpdateSocketLocations()
+void UCollisionHandlerComponent::ResolveSocketBindings(FCollisionPartState& Part)
 {
-	if (CollidingComponent)
+	// unresolved bindings fall back to GetSocketLocation
+	Part.SocketBindings.Reset();
+	Part.SocketBindings.SetNum(Part.Sockets.Num());
+	Part.ResolvedMeshAsset = GetCollidingMeshAsset(Part);
+
+	if (USkinnedMeshComponent* SkinnedComponent = Cast<USkinnedMeshComponent>(Part.CollidingComponent))
+	{
+		// components following master pose don't have their own bone transforms
+		if (SkinnedComponent->SkeletalMesh && SkinnedComponent->MasterPoseComponent.IsValid() == false)
+		{
+			for (int32 Index = 0; Index < Part.Sockets.Num(); ++Index)
+			{
+				FCollisionSocketBinding& Binding = Part.SocketBindings[Index];
+				if (const USkeletalMeshSocket* Socket = SkinnedComponent->SkeletalMesh->FindSocket(Part.Sockets[Index]))
+				{
+					Binding.BoneIndex = SkinnedComponent->GetBoneIndex(Socket->BoneName);
+					Binding.LocalOffset = Socket->RelativeLocation;
+				}
+				else
+				{
+					// socket name may be a bone name as well
+					Binding.BoneIndex = SkinnedComponent->GetBoneIndex(Part.Sockets[Index]);
+				}
+				Binding.bIsResolved = Binding.BoneIndex != INDEX_NONE;
+			}
+		}
+	}
+	else if (UStaticMeshComponent* StaticMeshComponent = Cast<UStaticMeshComponent>(Part.CollidingComponent))
 	{
-		// update location of sockets and store them in map
-		for (const FName& socketName : CollisionSockets)
+		if (UStaticMesh* StaticMesh = StaticMeshComponent->GetStaticMesh())
 		{
-			FVector socketLocation = CollidingComponent->GetSocketLocation(socketName);
-			LastFrameSocketLocations.Add(socketName, socketLocation);
+			for (int32 Index = 0; Index < Part.Sockets.Num(); ++Index)
+			{
+				if (const UStaticMeshSocket* Socket = StaticMesh->FindSocket(Part.Sockets[Index]))
+				{
+					FCollisionSocketBinding& Binding = Part.SocketBindings[Index];
+					Binding.LocalOffset = Socket->RelativeLocation;
+					Binding.bIsResolved = true;
+				}
+			}
 		}
 	}
 }
 
-void UCollisionHandlerComponent::PerformTraceCheck()
+UObject* UCollisionHandlerComponent::GetCollidingMeshAsset(const FCollisionPartState& Part)
+{
+	if (const USkinnedMeshComponent* SkinnedComponent = Cast<USkinnedMeshComponent>(Part.CollidingComponent))
+	{
+		return SkinnedComponent->SkeletalMesh;
+	}
+	if (const UStaticMeshComponent* StaticMeshComponent = Cast<UStaticMeshComponent>(Part.CollidingComponent))
+	{
+		return StaticMeshComponent->GetStaticMesh();
+	}
+	return nullptr;
+}
+
+void UCollisionHandlerComponent::SampleSocketLocations(FCollisionPartState& Part)
 {
-	if (CollidingComponent)
+	STARTERBUNDLE_SCOPE_CYCLE_COUNTER(STAT_UpdateSocketLocations);
+
+	// baked trajectories don't need bone transforms, live pose is used only outside of baked windows
+	if (Part.BakedTrajectories && SampleBakedSocketLocations(Part))
+	{
+		return;
+	}
+
+	if (Part.SocketBindings.Num() != Part.Sockets.Num())
 	{
-		// add owner to hit actors to make sure it will be ignored
-		HitActors.Add(GetOwner());
+		ResolveSocketBindings(Part);
+	}
+
+	Part.CurrentSocketLocations.SetNumUninitialized(Part.Sockets.Num(), false);
 
-		for (const FName& socketName : CollisionSockets)
+	// compute all socket locations in one batch from component space bone transforms
+	const FTransform ComponentToWorld = GetPoseComponentTransform(Part.CollidingComponent);
+	const USkinnedMeshComponent* SkinnedComponent = Cast<USkinnedMeshComponent>(Part.CollidingComponent);
+	const TArray<FTransform>* ComponentSpaceTransforms = SkinnedComponent ? &SkinnedComponent->GetComponentSpaceTransforms() : nullptr;
+
+	for (int32 Index = 0; Index < Part.Sockets.Num(); ++Index)
+	{
+		const FCollisionSocketBinding& Binding = Part.SocketBindings[Index];
+		if (Binding.bIsResolved == false)
+		{
+			Part.CurrentSocketLocations[Index] = Part.CollidingComponent->GetSocketLocation(Part.Sockets[Index]);
+		}
+		else if (Binding.BoneIndex == INDEX_NONE)
+		{
+			Part.CurrentSocketLocations[Index] = ComponentToWorld.TransformPosition(Binding.LocalOffset);
+		}
+		else if (ComponentSpaceTransforms && ComponentSpaceTransforms->IsValidIndex(Binding.BoneIndex))
 		{
-			FVector StartTrace = *LastFrameSocketLocations.Find(socketName);
-			FVector EndTrace = CollidingComponent->GetSocketLocation(socketName);
-			EDrawDebugTrace::Type DebugTraceType = (EDrawDebugTrace::Type)DebugMode;
-			TArray<FHitResult> HitResults;
+			const FVector ComponentSpaceLocation = (*ComponentSpaceTransforms)[Binding.BoneIndex].TransformPosition(Binding.LocalOffset);
+			Part.CurrentSocketLocations[Index] = ComponentToWorld.TransformPosition(ComponentSpaceLocation);
+		}
+		else
+		{
+			// pose not available yet, e.g. mesh was never ticked
+			Part.CurrentSocketLocations[Index] = Part.CollidingComponent->GetSocketLocation(Part.Sockets[Index]);
+		}
+	}
+}
+
+bool UCollisionHandlerComponent::SampleBakedSocketLocations(FCollisionPartState& Part)
+{
+	// montage position is advanced even if pose of mesh isn't evaluated
+	USkeletalMeshComponent* Mesh = Part.TrajectorySourceMesh.Get();
+	const UAnimInstance* AnimInstance = Mesh ? Mesh->GetAnimInstance() : nullptr;
+	const FAnimMontageInstance* MontageInstance = AnimInstance ? AnimInstance->GetActiveInstanceForMontage(Part.TrajectorySourceMontage) : nullptr;
+	if (MontageInstance == nullptr)
+	{
+		return false;
+	}
+
+	const float Position = MontageInstance->GetPosition();
 
-			bool WasHit =  UKismetSystemLibrary::SphereTraceMultiForObjects(this, StartTrace, EndTrace, TraceRadius, ObjectTypesToCollideWith,
-				bTraceComplex, HitActors, DebugTraceType, HitResults, true);
+	// sockets are matched by name only when window changes
+	if (Part.BakedTrajectories->Windows.IsValidIndex(Part.BakedWindowIndex) == false || Part.BakedTrajectories->Windows[Part.BakedWindowIndex].ContainsTime(Position) == false)
+	{
+		Part.BakedWindowIndex = Part.BakedTrajectories->FindWindow(Position);
+		if (Part.BakedWindowIndex == INDEX_NONE)
+		{
+			return false;
+		}
 
-			if (WasHit)
+		const FBakedSocketTrajectoryWindow& Window = Part.BakedTrajectories->Windows[Part.BakedWindowIndex];
+		Part.BakedSocketIndices.SetNumUninitialized(Part.Sockets.Num(), false);
+		for (int32 Index = 0; Index < Part.Sockets.Num(); ++Index)
+		{
+			Part.BakedSocketIndices[Index] = Window.Sockets.IndexOfByKey(Part.Sockets[Index]);
+			if (Part.BakedSocketIndices[Index] == INDEX_NONE)
 			{
-				for (const FHitResult& HitResult : HitResults)
-				{
-					if (HitActors.Contains(HitResult.GetActor()) == false &&
-						IsIgnoredClass(HitResult.GetActor()->GetClass()) == false &&
-						IsIgnoredProfileName(HitResult.Component->GetCollisionProfileName()) == false)
-					{
-						HitActors.Add(HitResult.GetActor());
-						NotifyOnHit(HitResult);
-					}
-				}
+				Part.BakedWindowIndex = INDEX_NONE;
+				return false;
 			}
 		}
 	}
+
+	const FBakedSocketTrajectoryWindow& Window = Part.BakedTrajectories->Windows[Part.BakedWindowIndex];
+	const FTransform& MeshToWorld = Mesh->GetComponentTransform();
+
+	Part.CurrentSocketLocations.SetNumUninitialized(Part.Sockets.Num(), false);
+	for (int32 Index = 0; Index < Part.Sockets.Num(); ++Index)
+	{
+		Part.CurrentSocketLocations[Index] = MeshToWorld.TransformPosition(Window.Sample(Part.BakedSocketIndices[Index], Position));
+	}
+	return true;
 }
 
-bool UCollisionHandlerComponent::IsIgnoredClass(TSubclassOf<AActor> ActorClass)
+void UCollisionHandlerComponent::UpdateSocketLocations(FCollisionPartState& Part)
 {
-	// if actor class is child or same class of any of ignored classes, return true, otherwise false
-	for (const auto& IgnoredClass : IgnoredClasses)
+	// keep one more sample of history to rebuild the arc between samples, only if last locations belong to this activation
+	Part.bHasSecondLastSocketLocations = (bInterpolateSocketArc || bUseAdaptiveTraceInterval) && Part.bCanPerformTrace;
+	if (Part.bHasSecondLastSocketLocations)
 	{
-		if (ActorClass->IsChildOf(IgnoredClass))
-			return true;
+		Swap(Part.SecondLastSocketLocations, Part.LastSocketLocations);
 	}
-	return false;
+
+	// current locations become last ones, arrays are swapped to reuse their memory
+	Swap(Part.LastSocketLocations, Part.CurrentSocketLocations);
 }
 
-bool UCollisionHandlerComponent::IsIgnoredProfileName(FName ProfileName)
+FVector UCollisionHandlerComponent::InterpolateSocketArc(const FVector& SecondLastLocation, const FVector& LastLocation, const FVector& CurrentLocation, float Alpha, float PreviousIntervalRatio)
 {
-	return IgnoredCollisionProfileNames.Contains(ProfileName);
+	// quadratic through three samples taken at Alpha = -PreviousIntervalRatio, 0 and 1, evenly spaced samples have ratio 1
+	const float Ratio = FMath::Max(PreviousIntervalRatio, KINDA_SMALL_NUMBER);
+	const FVector CurrentDelta = CurrentLocation - LastLocation;
+	const FVector Acceleration = (SecondLastLocation - LastLocation + Ratio * CurrentDelta) / (Ratio * (1.f + Ratio));
+	const FVector Velocity = CurrentDelta - Acceleration;
+	return LastLocation + Velocity * Alpha + Acceleration * Alpha * Alpha;
 }
 
-void UCollisionHandlerComponent::TraceCheckLoop()
+float UCollisionHandlerComponent::EstimateArcError(const FCollisionPartState& Part) const
+{
+	float MaxError = 0.f;
+	for (int32 Index = 0; Index < Part.CurrentSocketLocations.Num(); ++Index)
+	{
+		// arc deviates from its chord by a quarter of the part of quadratic term perpendicular to the chord
+		const FVector CurrentDelta = Part.CurrentSocketLocations[Index] - Part.LastSocketLocations[Index];
+		const FVector Acceleration = (Part.SecondLastSocketLocations[Index] - Part.LastSocketLocations[Index] + ArcIntervalRatio * CurrentDelta)
+			/ (ArcIntervalRatio * (1.f + ArcIntervalRatio));
+		const FVector ChordDirection = CurrentDelta.GetSafeNormal();
+		const FVector Bend = Acceleration - (Acceleration | ChordDirection) * ChordDirection;
+		MaxError = FMath::Max(MaxError, 0.25f * Bend.Size());
+	}
+	return MaxError;
+}
+
+void UCollisionHandlerComponent::UpdateAdaptiveTraceInterval(float ArcError, float StepInterval)
 {
-	// on first tick just update socket locations so on next tick it will be able to compare socket locations
-	if (bCanPerformTrace)
+	// first steps of activation keep initial interval until arc can be fitted
+	if (ArcError < 0.f || StepInterval <= 0.f)
 	{
-		PerformTraceCheck();
+		return;
 	}
 
-	UpdateSocketLocations();
-	bCanPerformTrace = true;
+	// distance between arc and chord grows with square of step time, interval may at most double per step so sudden strike isn't missed
+	const float Scale = ArcError > KINDA_SMALL_NUMBER ? FMath::Sqrt(MaxTraceDistanceError / ArcError) : 2.f;
+	const float IntervalScale = GetFidelityIntervalScale();
+	const float NewInterval = FMath::Clamp(StepInterval * FMath::Min(Scale, 2.f), IntervalScale * MinTraceCheckInterval,
+		IntervalScale * FMath::Max(MinTraceCheckInterval, MaxTraceCheckInterval));
 
+	// timer is rescheduled only on noticeable change, batched and pose driven loops read interval on every step
+	const bool bRescheduleTimer = bIsRegisteredInSubsystem == false && PoseSourceMesh == nullptr && FMath::Abs(NewInterval - CurrentTraceCheckInterval) > 0.1f * CurrentTraceCheckInterval;
+	CurrentTraceCheckInterval = NewInterval;
+
+	UWorld* World = GetWorld();
+	if (bRescheduleTimer && World)
+	{
+		World->GetTimerManager().SetTimer(TraceCheckTimerHandle, this, &UCollisionHandlerComponent::TraceCheckLoop, CurrentTraceCheckInterval, true);
+	}
 }
 
-void UCollisionHandlerComponent::UpdateCollidingComponentAndSockets(UPrimitiveComponent* Component, const TArray<FName>& Sockets)
+float UCollisionHandlerComponent::GetCurrentTraceCheckInterval() const
 {
-	CollidingComponent = Component;
-	CollisionSockets = Sockets;
+	return bIsCollisionActivated ? CurrentTraceCheckInterval : TraceCheckInterval;
 }
 
-void UCollisionHandlerComponent::ActivateCollision(ECollisionPart CollisionPart)
+void UCollisionHandlerComponent::ResetTraceCheckInterval()
 {
-	bIsCollisionActivated = true;
-	HitActors.Empty();
+	// adaptive interval starts from fixed one and is picked again after every step, lower fidelity tiers stretch both
+	const float Interval = bUseAdaptiveTraceInterval ? FMath::Clamp(TraceCheckInterval, MinTraceCheckInterval, FMath::Max(MinTraceCheckInterval, MaxTraceCheckInterval)) : TraceCheckInterval;
+	CurrentTraceCheckInterval = GetFidelityIntervalScale() * Interval;
+	LastTraceCheckTime = -1.f;
+	LastStepInterval = 0.f;
 
-	// set timer which will check for collisions
-	GetWorld()->GetTimerManager().SetTimer(TraceCheckTimerHandle, this, &UCollisionHandlerComponent::TraceCheckLoop, TraceCheckInterval, true);
-	
-	// call OnCollisionActivated delegates
-	NotifyOnCollisionActivated(CollisionPart);
+	UWorld* World = GetWorld();
+	if (World && World->GetTimerManager().IsTimerActive(TraceCheckTimerHandle))
+	{
+		World->GetTimerManager().SetTimer(TraceCheckTimerHandle, this, &UCollisionHandlerComponent::TraceCheckLoop, CurrentTraceCheckInterval, true);
+	}
 }
 
-void UCollisionHandlerComponent::DeactivateCollision()
+float UCollisionHandlerComponent::ComputeSignificance() const
 {
-	bIsCollisionActivated = false;
-	bCanPerformTrace = false;
-	
-	// clear timer checking for collision
-	GetWorld()->GetTimerManager().ClearTimer(TraceCheckTimerHandle);
+	UWorld* World = GetWorld();
+	UCollisionHandlerSubsystem* Subsystem = World ? World->GetSubsystem<UCollisionHandlerSubsystem>() : nullptr;
+	const AActor* Owner = GetOwner();
+	if (Subsystem == nullptr || Owner == nullptr)
+	{
+		return 1.f;
+	}
 
-	// call OnCollisionDeactivated delegates
-	NotifyOnCollisionDeactivated();
+	// player is always involved in fights of own pawn
+	const APawn* OwnerPawn = Cast<APawn>(Owner);
+	if (OwnerPawn && OwnerPawn->IsPlayerControlled())
+	{
+		return 1.f;
+	}
+
+	const TArray<FVector>& PlayerLocations = Subsystem->GetPlayerLocations();
+	if (PlayerLocations.Num() == 0)
+	{
+		return 0.f;
+	}
+
+	const FVector OwnerLocation = Owner->GetActorLocation();
+	float MinDistanceSquared = MAX_flt;
+	for (const FVector& PlayerLocation : PlayerLocations)
+	{
+		MinDistanceSquared = FMath::Min(MinDistanceSquared, FVector::DistSquared(OwnerLocation, PlayerLocation));
+	}
+
+	// player that close is attacked or attacks, so fight gets full fidelity no matter whether it is visible
+	const float Distance = FMath::Sqrt(MinDistanceSquared);
+	const float FullDistance = SignificanceSettings.FullSignificanceDistance;
+	if (Distance <= FullDistance)
+	{
+		return 1.f;
+	}
+
+	float Result = 1.f - FMath::Clamp((Distance - FullDistance) / FMath::Max(SignificanceSettings.ZeroSignificanceDistance - FullDistance, KINDA_SMALL_NUMBER), 0.f, 1.f);
+
+	// dedicated server doesn't render anything
+	if (GetNetMode() != NM_DedicatedServer && Owner->WasRecentlyRendered(0.2f) == false)
+	{
+		Result *= SignificanceSettings.HiddenSignificanceScale;
+	}
+	return Result;
 }
 
-TArray<FName> UCollisionHandlerComponent::GetCollisionSockets() const
+void UCollisionHandlerComponent::UpdateFidelityTier(bool bIgnoreUpdateInterval)
 {
-	return CollisionSockets;
+	if (bUseFidelityTiers == false || FidelityTiers.Num() == 0)
+	{
+		FidelityTierIndex = 0;
+		Significance = 1.f;
+		return;
+	}
+
+	const float Time = GetWorld()->GetTimeSeconds();
+	if (bIgnoreUpdateInterval == false && Time < NextSignificanceUpdateTime)
+	{
+		return;
+	}
+
+	NextSignificanceUpdateTime = Time + SignificanceSettings.UpdateInterval;
+	Significance = ComputeSignificance();
+
+	const int32 CurrentTier = FMath::Clamp(FidelityTierIndex, 0, FidelityTiers.Num() - 1);
+	int32 TargetTier = FidelityTiers.Num() - 1;
+	for (int32 Index = 0; Index < FidelityTiers.Num(); ++Index)
+	{
+		if (Significance >= FidelityTiers[Index].MinSignificance)
+		{
+			TargetTier = Index;
+			break;
+		}
+	}
+
+	// significance has to get past threshold by hysteresis and tier has to be kept for a while, so tier doesn't flicker around threshold
+	if (TargetTier != CurrentTier)
+	{
+		const bool bIsRaising = TargetTier < CurrentTier;
+		const float Threshold = GetFidelityTierChangeThreshold(FidelityTiers, CurrentTier, bIsRaising, SignificanceSettings.Hysteresis);
+		const bool bIsPastThreshold = bIsRaising ? Significance >= Threshold : Significance < Threshold;
+		if (bIsPastThreshold == false || Time - FidelityTierChangeTime < SignificanceSettings.MinTierDuration)
+		{
+			TargetTier = CurrentTier;
+		}
+	}
+
+	if (TargetTier == FidelityTierIndex)
+	{
+		return;
+	}
+
+	const bool bWasSampling = FidelityTiers[CurrentTier].bMidpointOverlapOnly == false;
+	FidelityTierIndex = TargetTier;
+	FidelityTierChangeTime = Time;
+
+	// all sockets are sampled in every tier that traces, tiers only pick which of them are swept and how, so last samples stay valid
+	// and sweeping continues across the change, sampling starts over only after tier that didn't sample at all
+	if (bWasSampling == false)
+	{
+		for (uint32 Mask = ActiveStateMask; Mask != 0; Mask &= Mask - 1)
+		{
+			CollisionParts[FMath::CountTrailingZeros(Mask)].bCanPerformTrace = false;
+		}
+	}
+	ResetTraceCheckInterval();
 }
 
-UPrimitiveComponent* UCollisionHandlerComponent::GetCollidingComponent() const
+float UCollisionHandlerComponent::GetFidelityTierChangeThreshold(const TArray<FCollisionFidelityTier>& Tiers, int32 CurrentTier, bool bIsRaising, float Hysteresis)
 {
-	return CollidingComponent;
+	// boundary between CurrentTier and its neighbour, tiers are ordered by decreasing MinSignificance
+	const int32 HigherTier = bIsRaising ? CurrentTier - 1 : CurrentTier;
+	if (Tiers.IsValidIndex(HigherTier) == false || Tiers.IsValidIndex(HigherTier + 1) == false)
+	{
+		return bIsRaising ? 1.f : 0.f;
+	}
+
+	// thresholds stay inside range of significance in which neighbouring tier is the target, otherwise it couldn't be entered
+	const float Boundary = Tiers[HigherTier].MinSignificance;
+	const float Gap = FMath::Max(Boundary - Tiers[HigherTier + 1].MinSignificance, 0.f);
+	const float ClampedHysteresis = FMath::Clamp(Hysteresis, 0.f, 0.5f * Gap);
+	return bIsRaising ? FMath::Min(Boundary + ClampedHysteresis, 1.f) : Boundary - ClampedHysteresis;
 }
 
-bool UCollisionHandlerComponent::IsCollisionActivated() const
+const FCollisionFidelityTier* UCollisionHandlerComponent::GetActiveFidelityTier() const
 {
-	return bIsCollisionActivated;
+	return bUseFidelityTiers && FidelityTiers.IsValidIndex(FidelityTierIndex) ? &FidelityTiers[FidelityTierIndex] : nullptr;
 }
 
-ECollisionPart UCollisionHandlerComponent::GetActivatedCollisionPart() const
+float UCollisionHandlerComponent::GetFidelityIntervalScale() const
 {
-	return ActivatedCollisionPart;
+	const FCollisionFidelityTier* Tier = GetActiveFidelityTier();
+	return Tier ? FMath::Max(Tier->IntervalScale, 1.f) : 1.f;
+}
+
+int32 UCollisionHandlerComponent::GetFidelityTier() const
+{
+	return GetActiveFidelityTier() ? FidelityTierIndex : 0;
+}
+
+float UCollisionHandlerComponent::GetSignificance() const
+{
+	return bUseFidelityTiers ? Significance : 1.f;
+}
+
+void UCollisionHandlerComponent::PerformMidpointOverlap()
+{
+	bHasDoneMidpointOverlap = true;
+
+	UWorld* World = GetWorld();
+	if (World == nullptr)
+	{
+		return;
+	}
+
+	for (uint32 Mask = ActiveStateMask; Mask != 0; Mask &= Mask - 1)
+	{
+		FCollisionPartState& Part = CollisionParts[FMath::CountTrailingZeros(Mask)];
+		if (Part.CollidingComponent == nullptr)
+		{
+			continue;
+		}
+
+		SampleSocketLocations(Part);
+		const TArray<FVector>& SocketLocations = Part.CurrentSocketLocations;
+		if (SocketLocations.Num() == 0)
+		{
+			continue;
+		}
+
+		// blade capsule from first to last socket, or sphere of single socket, overlapped at one place
+		FCollisionSweepSegment Segment(SocketLocations[0], SocketLocations[0]);
+		if (SocketLocations.Num() >= 2)
+		{
+			const FVector Blade = SocketLocations.Last() - SocketLocations[0];
+			const FVector Center = 0.5f * (SocketLocations[0] + SocketLocations.Last());
+			Segment = FCollisionSweepSegment(Center, Center, FRotationMatrix::MakeFromZ(Blade.GetSafeNormal()).ToQuat(), 0.5f * Blade.Size() + TraceRadius);
+		}
+
+		STARTERBUNDLE_INC_COUNTER(STAT_MidpointOverlaps, 1);
+		ScratchOverlaps.Reset();
+		World->OverlapMultiByObjectType(ScratchOverlaps, Segment.Start, Segment.Rotation, ActivationObjectQueryParams, MakeSweepShape(Segment), ActivationQueryParams);
+
+		// overlapped components are processed as hits located in the center of the shape
+		ScratchHitResults.Reset();
+		for (const FOverlapResult& Overlap : ScratchOverlaps)
+		{
+			AActor* OverlapActor = Overlap.GetActor();
+			UPrimitiveComponent* OverlapComponent = Overlap.GetComponent();
+			if (OverlapActor && OverlapComponent)
+			{
+				FHitResult HitResult(OverlapActor, OverlapComponent, Segment.Start, (Segment.Start - OverlapComponent->GetComponentLocation()).GetSafeNormal());
+				HitResult.TraceStart = Segment.Start;
+				HitResult.TraceEnd = Segment.End;
+				HitResult.bBlockingHit = false;
+				ScratchHitResults.Add(HitResult);
+			}
+		}
+
+		DebugSweep(Segment, ScratchHitResults.Num() > 0, ScratchHitResults);
+		ProcessHitResults(ScratchHitResults);
+	}
+}
+
+void UCollisionHandlerComponent::GatherSweepSegments(const FCollisionPartState& Part, int32 NumArcSubsteps)
+{
+	// sockets changed since last sample, wait for the next one
+	if (Part.LastSocketLocations.Num() != Part.CurrentSocketLocations.Num())
+	{
+		return;
+	}
+
+	const FCollisionFidelityTier* Tier = GetActiveFidelityTier();
+	const bool bSweepBlade = TraceShape == ECollisionTraceShape::BladeCapsule || (Tier && Tier->bForceBladeCapsule);
+	if (bSweepBlade && Part.CurrentSocketLocations.Num() >= 2)
+	{
+		GatherBladeSweepSegments(Part, NumArcSubsteps);
+		return;
+	}
+
+	const int32 NumSockets = Part.CurrentSocketLocations.Num();
+	const int32 NumSweptSockets = Tier && Tier->MaxSockets > 0 ? FMath::Min(Tier->MaxSockets, NumSockets) : NumSockets;
+	for (int32 SweptIndex = 0; SweptIndex < NumSweptSockets; ++SweptIndex)
+	{
+		// fewer sockets are picked evenly from first to last one, single socket is the last one (usually tip)
+		const int32 Index = NumSweptSockets == NumSockets ? SweptIndex
+			: NumSweptSockets > 1 ? FMath::RoundToInt(SweptIndex * (NumSockets - 1) / (float)(NumSweptSockets - 1)) : NumSockets - 1;
+		FVector StartTrace = Part.LastSocketLocations[Index];
+		const FVector& EndTrace = Part.CurrentSocketLocations[Index];
+
+		// split straight sweep into several ones following the arc fitted to socket history
+		if (Part.bHasSecondLastSocketLocations && NumArcSubsteps > 1)
+		{
+			const FVector& SecondLastLocation = Part.SecondLastSocketLocations[Index];
+			const FVector& LastLocation = Part.LastSocketLocations[Index];
+			for (int32 Substep = 1; Substep < NumArcSubsteps; ++Substep)
+			{
+				const float Alpha = (float)Substep / (float)NumArcSubsteps;
+				const FVector SubstepLocation = InterpolateSocketArc(SecondLastLocation, LastLocation, EndTrace, Alpha, ArcIntervalRatio);
+				SweepSegments.Add(FCollisionSweepSegment(StartTrace, SubstepLocation));
+				StartTrace = SubstepLocation;
+			}
+		}
+
+		SweepSegments.Add(FCollisionSweepSegment(StartTrace, EndTrace));
+	}
+}
+
+void UCollisionHandlerComponent::GatherBladeSweepSegments(const FCollisionPartState& Part, int32 NumArcSubsteps)
+{
+	// blade is a segment between first and last socket, sockets in between are covered by capsule
+	const int32 TipIndex = Part.CurrentSocketLocations.Num() - 1;
+
+	FVector StartBase = Part.LastSocketLocations[0];
+	FVector StartTip = Part.LastSocketLocations[TipIndex];
+	const FVector LastBase = StartBase;
+	const FVector LastTip = StartTip;
+	const FVector& CurrentBase = Part.CurrentSocketLocations[0];
+	const FVector& CurrentTip = Part.CurrentSocketLocations[TipIndex];
+
+	const bool bFollowArc = Part.bHasSecondLastSocketLocations;
+	const FVector* SecondLastBase = bFollowArc ? &Part.SecondLastSocketLocations[0] : nullptr;
+	const FVector* SecondLastTip = bFollowArc ? &Part.SecondLastSocketLocations[TipIndex] : nullptr;
+
+	// capsule orientation is fixed during a sweep, so split sweep if blade rotates too much
+	const float BladeAngle = FMath::RadiansToDegrees(FMath::Acos(FMath::Clamp(
+		FVector::DotProduct((LastTip - LastBase).GetSafeNormal(), (CurrentTip - CurrentBase).GetSafeNormal()), -1.f, 1.f)));
+	const int32 NumSweeps = FMath::Max3(1, bFollowArc ? NumArcSubsteps : 1, FMath::CeilToInt(BladeAngle / MaxBladeSweepAngle));
+
+	for (int32 Sweep = 1; Sweep <= NumSweeps; ++Sweep)
+	{
+		const float Alpha = (float)Sweep / (float)NumSweeps;
+		FVector EndBase = CurrentBase;
+		FVector EndTip = CurrentTip;
+		if (Sweep < NumSweeps)
+		{
+			EndBase = bFollowArc ? InterpolateSocketArc(*SecondLastBase, LastBase, CurrentBase, Alpha, ArcIntervalRatio) : FMath::Lerp(LastBase, CurrentBase, Alpha);
+			EndTip = bFollowArc ? InterpolateSocketArc(*SecondLastTip, LastTip, CurrentTip, Alpha, ArcIntervalRatio) : FMath::Lerp(LastTip, CurrentTip, Alpha);
+		}
+
+		// orient capsule along average blade direction and make it long enough to cover the blade on both ends
+		const FVector StartBlade = StartTip - StartBase;
+		const FVector EndBlade = EndTip - EndBase;
+		FVector BladeAxis = (StartBlade.GetSafeNormal() + EndBlade.GetSafeNormal()).GetSafeNormal();
+		if (BladeAxis.IsNearlyZero())
+		{
+			BladeAxis = StartBlade.GetSafeNormal();
+		}
+		const float HalfBladeLength = 0.5f * FMath::Max(StartBlade.Size(), EndBlade.Size());
+		const FQuat Rotation = FRotationMatrix::MakeFromZ(BladeAxis).ToQuat();
+
+		// both blade poses are rotated away from average axis, their ends are off axis by half length times sine of that angle
+		const float SinAngleToAxis = FMath::Max((StartBlade.GetSafeNormal() ^ BladeAxis).Size(), (EndBlade.GetSafeNormal() ^ BladeAxis).Size());
+		const float RadiusPadding = HalfBladeLength * SinAngleToAxis;
+
+		SweepSegments.Add(FCollisionSweepSegment(0.5f * (StartBase + StartTip), 0.5f * (EndBase + EndTip), Rotation, HalfBladeLength + TraceRadius + RadiusPadding, RadiusPadding));
+
+		StartBase = EndBase;
+		StartTip = EndTip;
+	}
+}
+
+FCollisionQueryParams UCollisionHandlerComponent::MakeQueryParams() const
+{
+	// same query setup as UKismetSystemLibrary::SphereTraceMultiForObjects
+	FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(CollisionHandlerTrace), bTraceComplex);
+	QueryParams.bReturnPhysicalMaterial = true;
+	QueryParams.AddIgnoredActors(IgnoredActors);
+	QueryParams.AddIgnoredComponents(IgnoredComponents);
+	return QueryParams;
+}
+
+FCollisionShape UCollisionHandlerComponent::MakeSweepShape(const FCollisionSweepSegment& Segment) const
+{
+	const float Radius = TraceRadius + Segment.RadiusPadding;
+	return Segment.IsCapsule() ? FCollisionShape::MakeCapsule(Radius, Segment.HalfHeight) : FCollisionShape::MakeSphere(Radius);
+}
+
+bool UCollisionHandlerComponent::SweepSegment(const FCollisionSweepSegment& Segment, const FCollisionQueryParams& QueryParams, TArray<FHitResult>& OutHitResults)
+{
+	UWorld* World = GetWorld();
+	if (World == nullptr)
+	{
+		return false;
+	}
+
+	return World->SweepMultiByObjectType(OutHitResults, Segment.Start, Segment.End, Segment.Rotation,
+		ActivationObjectQueryParams, MakeSweepShape(Segment), QueryParams);
+}
+
+bool UCollisionHandlerComponent::PerformSweep(const FCollisionSweepSegment& Segment, TArray<FHitResult>& OutHitResults)
+{
+	return bUseHurtboxNarrowphase && Segment.IsCapsule() == false
+		? SweepHurtboxes(Segment, OutHitResults)
+		: SweepSegment(Segment, ActivationQueryParams, OutHitResults);
+}
+
+bool UCollisionHandlerComponent::GatherHurtboxCandidates()
+{
+	HurtboxCandidates.Reset();
+
+	UWorld* World = GetWorld();
+	UCollisionHandlerSubsystem* Subsystem = World ? World->GetSubsystem<UCollisionHandlerSubsystem>() : nullptr;
+	if (Subsystem == nullptr)
+	{
+		// without hurtboxes there is nothing to cull by
+		return true;
+	}
+
+	FBox SweptBounds(ForceInit);
+	for (const FCollisionSweepSegment& Segment : SweepSegments)
+	{
+		const FVector Extent(TraceRadius + Segment.RadiusPadding + (Segment.IsCapsule() ? Segment.HalfHeight : 0.f));
+		SweptBounds += FBox(Segment.Start - Extent, Segment.Start + Extent);
+		SweptBounds += FBox(Segment.End - Extent, Segment.End + Extent);
+	}
+
+	Subsystem->QueryHurtboxes(SweptBounds, HurtboxCandidates);
+
+	// own hurtbox always overlaps own sockets and actors already hit can't be hit again, neither of them keeps trace check alive
+	HurtboxCandidates.RemoveAllSwap([this, Subsystem](int32 OwnerIndex)
+	{
+		UHurtboxComponent* Hurtbox = Subsystem->GetHurtbox(OwnerIndex);
+		return Hurtbox == nullptr || IgnoredActors.Contains(Hurtbox->GetOwner());
+	}, false);
+
+	return HurtboxCandidates.Num() > 0;
+}
+
+bool UCollisionHandlerComponent::SweepHurtboxes(const FCollisionSweepSegment& Segment, TArray<FHitResult>& OutHitResults)
+{
+	UWorld* World = GetWorld();
+	UCollisionHandlerSubsystem* Subsystem = World ? World->GetSubsystem<UCollisionHandlerSubsystem>() : nullptr;
+	if (Subsystem == nullptr)
+	{
+		return false;
+	}
+
+	const FHurtboxCapsuleSet& HurtboxCapsules = Subsystem->GetHurtboxCapsules();
+	TArray<FHurtboxCapsuleHit>& CapsuleHits = ScratchCapsuleHits;
+	CapsuleHits.Reset();
+	if (bUseHurtboxBroadphase)
+	{
+		for (int32 OwnerIndex : HurtboxCandidates)
+		{
+			int32 FirstCapsule, NumCapsules;
+			Subsystem->GetHurtboxCapsuleRange(OwnerIndex, FirstCapsule, NumCapsules);
+			HurtboxCapsules.SweepSphere(Segment.Start, Segment.End, TraceRadius, FirstCapsule, NumCapsules, CapsuleHits);
+		}
+	}
+	else
+	{
+		HurtboxCapsules.SweepSphere(Segment.Start, Segment.End, TraceRadius, CapsuleHits);
+	}
+
+	const FVector SweepDelta = Segment.End - Segment.Start;
+	const float SweepLengthSquared = SweepDelta.SizeSquared();
+
+	for (const FHurtboxCapsuleHit& CapsuleHit : CapsuleHits)
+	{
+		// same filtering as ignore lists passed to physics query
+		UHurtboxComponent* Hurtbox = Subsystem->GetHurtbox(HurtboxCapsules.GetOwnerIndex(CapsuleHit.CapsuleIndex));
+		AActor* HitActor = Hurtbox ? Hurtbox->GetOwner() : nullptr;
+		USkeletalMeshComponent* HitMesh = Hurtbox ? Hurtbox->GetHurtboxMesh() : nullptr;
+		if (HitActor == nullptr || HitMesh == nullptr || IgnoredActors.Contains(HitActor) || IgnoredComponents.Contains(HitMesh))
+		{
+			continue;
+		}
+
+		// impact is on capsule surface facing the swept sphere
+		FVector ImpactNormal = (CapsuleHit.SweepLocation - CapsuleHit.CapsuleLocation).GetSafeNormal();
+		if (ImpactNormal.IsZero())
+		{
+			ImpactNormal = -SweepDelta.GetSafeNormal();
+		}
+
+		FHitResult HitResult(HitActor, HitMesh, CapsuleHit.SweepLocation, ImpactNormal);
+		HitResult.ImpactPoint = CapsuleHit.CapsuleLocation + ImpactNormal * HurtboxCapsules.GetRadius(CapsuleHit.CapsuleIndex);
+		HitResult.ImpactNormal = ImpactNormal;
+		HitResult.TraceStart = Segment.Start;
+		HitResult.TraceEnd = Segment.End;
+		HitResult.Time = SweepLengthSquared > KINDA_SMALL_NUMBER ? ((CapsuleHit.SweepLocation - Segment.Start) | SweepDelta) / SweepLengthSquared : 0.f;
+		HitResult.BoneName = HurtboxCapsules.GetBoneName(CapsuleHit.CapsuleIndex);
+		HitResult.bBlockingHit = false;
+		OutHitResults.Add(HitResult);
+	}
+
+	return OutHitResults.Num() > 0;
+}
+
+void UCollisionHandlerComponent::DebugSweep(const FCollisionSweepSegment& Segment, bool bWasHit, const TArray<FHitResult>& HitResults) const
+{
+	if (DebugMode == ECollisionHandlerDebugMode::Record)
+	{
+		RecordSweep(Segment.Start, Segment.End, TraceRadius + Segment.RadiusPadding, Segment.IsCapsule() ? Segment.HalfHeight : 0.f, bWasHit);
+		return;
+	}
+
+#if ENABLE_DRAW_DEBUG
+	UWorld* World = GetWorld();
+	if (World && DebugMode != ECollisionHandlerDebugMode::None)
+	{
+		// same draw durations as Kismet trace debug drawing
+		const bool bPersistent = DebugMode == ECollisionHandlerDebugMode::Persistant;
+		const float LifeTime = DebugMode == ECollisionHandlerDebugMode::ForDuration ? 5.f : 0.f;
+		const FColor Color = bWasHit ? FColor::Green : FColor::Red;
+		const float Radius = TraceRadius + Segment.RadiusPadding;
+		const float HalfHeight = Segment.IsCapsule() ? Segment.HalfHeight : Radius;
+		DrawDebugCapsule(World, Segment.Start, HalfHeight, Radius, Segment.Rotation, Color, bPersistent, LifeTime);
+		DrawDebugCapsule(World, Segment.End, HalfHeight, Radius, Segment.Rotation, Color, bPersistent, LifeTime);
+		DrawDebugLine(World, Segment.Start, Segment.End, Color, bPersistent, LifeTime);
+		for (const FHitResult& HitResult : HitResults)
+		{
+			DrawDebugPoint(World, HitResult.ImpactPoint, 16.f, FColor::Red, bPersistent, LifeTime);
+		}
+	}
+#endif
+}
+
+void UCollisionHandlerComponent::RecordSweep(const FVector& Start, const FVector& End, float Radius, float HalfHeight, bool bWasHit) const
+{
+	UWorld* World = GetWorld();
+	UCollisionHandlerSubsystem* Subsystem = World ? World->GetSubsystem<UCollisionHandlerSubsystem>() : nullptr;
+	if (Subsystem)
+	{
+		FCollisionTraceRecord TraceRecord;
+		TraceRecord.Start = Start;
+		TraceRecord.End = End;
+		TraceRecord.Radius = Radius;
+		TraceRecord.HalfHeight = HalfHeight;
+		TraceRecord.Frame = (uint32)GFrameCounter;
+		TraceRecord.HandlerId = GetUniqueID();
+		TraceRecord.bHit = bWasHit;
+		Subsystem->GetTraceRecorder().Record(TraceRecord, GetOwner());
+	}
+}
+
+void UCollisionHandlerComponent::PerformTraceCheck()
+{
+	STARTERBUNDLE_SCOPE_CYCLE_COUNTER(STAT_PerformTraceCheck);
+
+	if (SweepSegments.Num() > 0)
+	{
+		if (bUseHurtboxBroadphase && GatherHurtboxCandidates() == false)
+		{
+			STARTERBUNDLE_INC_COUNTER(STAT_TraceChecksCulled, 1);
+			return;
+		}
+
+		NumSweepsIssued += SweepSegments.Num();
+		STARTERBUNDLE_INC_COUNTER(STAT_SweepsIssued, SweepSegments.Num());
+
+		if (bUseAsyncTrace)
+		{
+			PerformAsyncTraceCheck();
+			return;
+		}
+
+		// subsystem sweeps segments of all handlers on worker threads and merges their hits back in order of handlers
+		if (bShouldDeferSweeps)
+		{
+			bHasDeferredSweeps = true;
+			return;
+		}
+
+		for (const FCollisionSweepSegment& Segment : SweepSegments)
+		{
+			ScratchHitResults.Reset();
+
+			// components rejected by previous sweep are already in query params and filtered out by physics
+			const bool bWasHit = PerformSweep(Segment, ScratchHitResults);
+			DebugSweep(Segment, bWasHit, ScratchHitResults);
+
+			if (bWasHit)
+			{
+				ProcessHitResults(ScratchHitResults);
+			}
+		}
+	}
+}
+
+void UCollisionHandlerComponent::PerformDeferredSweeps()
+{
+	// runs on trace workers, tracking is per thread so worker sweeps are counted like game thread ones
+	STARTERBUNDLE_ALLOCATION_SCOPE(true);
+
+	DeferredHitResults.Reset();
+	DeferredHitCounts.Reset();
+
+	// scene queries only read, debug drawing, recording and hit processing wait for game thread
+	for (const FCollisionSweepSegment& Segment : SweepSegments)
+	{
+		ScratchHitResults.Reset();
+		PerformSweep(Segment, ScratchHitResults);
+		DeferredHitResults.Append(ScratchHitResults);
+		DeferredHitCounts.Add(ScratchHitResults.Num());
+	}
+}
+
+void UCollisionHandlerComponent::MergeDeferredSweeps()
+{
+	if (bHasDeferredSweeps == false)
+	{
+		return;
+	}
+
+	bHasDeferredSweeps = false;
+
+	// all segments were swept with the same query params, so actors hit by earlier segment are merged by hit registry instead of physics filter
+	int32 FirstHit = 0;
+	const int32 NumSegments = FMath::Min(SweepSegments.Num(), DeferredHitCounts.Num());
+	for (int32 Index = 0; Index < NumSegments; ++Index)
+	{
+		const int32 NumHits = DeferredHitCounts[Index];
+		ScratchHitResults.Reset();
+		ScratchHitResults.Append(DeferredHitResults.GetData() + FirstHit, NumHits);
+		FirstHit += NumHits;
+
+		DebugSweep(SweepSegments[Index], NumHits > 0, ScratchHitResults);
+
+		if (NumHits > 0)
+		{
+			ProcessHitResults(ScratchHitResults);
+		}
+	}
+}
+
+void UCollisionHandlerComponent::PerformAsyncTraceCheck()
+{
+	UWorld* World = GetWorld();
+	if (World == nullptr)
+	{
+		return;
+	}
+
+	// results are delivered on the next frame, user data is used to drop results of previous activations
+	for (const FCollisionSweepSegment& Segment : SweepSegments)
+	{
+		World->AsyncSweepByObjectType(EAsyncTraceType::Multi, Segment.Start, Segment.End, Segment.Rotation, ActivationObjectQueryParams, MakeSweepShape(Segment),
+			ActivationQueryParams, &AsyncTraceDelegate, ActivationId);
+	}
+}
+
+void UCollisionHandlerComponent::OnAsyncTraceCompleted(const FTraceHandle& TraceHandle, FTraceDatum& TraceDatum)
+{
+	STARTERBUNDLE_SCOPE_CYCLE_COUNTER(STAT_AsyncTraceResults);
+
+	// sweeps issued right before deactivation cover the end of the window and are still processed, only results of previous activations are ignored
+	if (TraceDatum.UserData == ActivationId)
+	{
+		if (DebugMode == ECollisionHandlerDebugMode::Record)
+		{
+			const FCollisionShape& Shape = TraceDatum.CollisionParams.CollisionShape;
+			RecordSweep(TraceDatum.Start, TraceDatum.End, Shape.IsCapsule() ? Shape.GetCapsuleRadius() : Shape.GetSphereRadius(),
+				Shape.IsCapsule() ? Shape.GetCapsuleHalfHeight() : 0.f, TraceDatum.OutHits.Num() > 0);
+		}
+
+		ProcessHitResults(TraceDatum.OutHits);
+	}
+}
+
+void UCollisionHandlerComponent::ProcessHitResults(const TArray<FHitResult>& HitResults)
+{
+	STARTERBUNDLE_ALLOCATION_SCOPE(false);
+
+	const float Time = GetWorld()->GetTimeSeconds();
+	STARTERBUNDLE_INC_COUNTER(STAT_HitResultsReturned, HitResults.Num());
+
+	for (const FHitResult& HitResult : HitResults)
+	{
+		AActor* HitActor = HitResult.GetActor();
+		UPrimitiveComponent* HitComponent = HitResult.GetComponent();
+		if (HitActor == nullptr || HitComponent == nullptr)
+		{
+			STARTERBUNDLE_INC_COUNTER(STAT_HitsFiltered, 1);
+			continue;
+		}
+
+		// most ignored actors and components are filtered by PrefilterIgnoreRules, ones that came into reach later are passed to physics query filter here
+		if (IsIgnoredClass(HitActor->GetClass()))
+		{
+			IgnoreActor(HitActor);
+			STARTERBUNDLE_INC_COUNTER(STAT_HitsFiltered, 1);
+			continue;
+		}
+		if (IsIgnoredProfileName(HitComponent->GetCollisionProfileName()))
+		{
+			IgnoreComponent(HitComponent);
+			STARTERBUNDLE_INC_COUNTER(STAT_HitsFiltered, 1);
+			continue;
+		}
+
+		if (HitRegistry.TryRegisterHit(HitActor, Time, RehitSettings))
+		{
+			// actor can't be hit again during this activation, so following traces can skip it
+			if (RehitSettings.Policy == ECollisionRehitPolicy::OncePerActivation)
+			{
+				IgnoreActor(HitActor);
+			}
+			NotifyOnHit(HitResult);
+		}
+		else
+		{
+			STARTERBUNDLE_INC_COUNTER(STAT_HitsFiltered, 1);
+		}
+	}
+}
+
+void UCollisionHandlerComponent::CompileIgnoreRules()
+{
+	// answers of class checks stay valid as long as ignored classes don't change
+	if (CompiledIgnoredClasses != IgnoredClasses)
+	{
+		CompiledIgnoredClasses = IgnoredClasses;
+		IgnoredClassCache.Reset();
+	}
+
+	IgnoredProfileNameSet.Reset();
+	IgnoredProfileNameSet.Append(IgnoredCollisionProfileNames);
+
+	IgnoredComponents.Reset();
+}
+
+void UCollisionHandlerComponent::PrefilterIgnoreRules()
+{
+	UWorld* World = GetWorld();
+	if (World == nullptr || (IgnoredClasses.Num() == 0 && IgnoredProfileNameSet.Num() == 0))
+	{
+		return;
+	}
+
+	// region which colliding components can reach during activation
+	FBox Bounds = GetOwner()->GetComponentsBoundingBox();
+	for (const FCollisionPartState& Part : CollisionParts)
+	{
+		if (Part.CollidingComponent)
+		{
+			Bounds += Part.CollidingComponent->Bounds.GetBox();
+		}
+	}
+	if (Bounds.IsValid == false)
+	{
+		return;
+	}
+	Bounds = Bounds.ExpandBy(IgnoreRulesPrefilterReach);
+
+	// single broadphase query with the same filter as sweeps, rules are applied to what it returns before any sweep runs
+	ScratchOverlaps.Reset();
+	World->OverlapMultiByObjectType(ScratchOverlaps, Bounds.GetCenter(), FQuat::Identity, ActivationObjectQueryParams,
+		FCollisionShape::MakeBox(Bounds.GetExtent()), ActivationQueryParams);
+
+	for (const FOverlapResult& Overlap : ScratchOverlaps)
+	{
+		AActor* OverlapActor = Overlap.GetActor();
+		UPrimitiveComponent* OverlapComponent = Overlap.GetComponent();
+		if (OverlapActor && IsIgnoredClass(OverlapActor->GetClass()))
+		{
+			IgnoreActor(OverlapActor);
+		}
+		else if (OverlapComponent && IsIgnoredProfileName(OverlapComponent->GetCollisionProfileName()))
+		{
+			IgnoreComponent(OverlapComponent);
+		}
+	}
+	ScratchOverlaps.Reset();
+}
+
+void UCollisionHandlerComponent::IgnoreActor(AActor* Actor)
+{
+	if (IgnoredActors.Contains(Actor) == false)
+	{
+		IgnoredActors.Add(Actor);
+		ActivationQueryParams.AddIgnoredActor(Actor);
+	}
+}
+
+void UCollisionHandlerComponent::IgnoreComponent(UPrimitiveComponent* Component)
+{
+	if (IgnoredComponents.Contains(Component) == false)
+	{
+		IgnoredComponents.Add(Component);
+		ActivationQueryParams.AddIgnoredComponent(Component);
+	}
+}
+
+bool UCollisionHandlerComponent::IsIgnoredClass(TSubclassOf<AActor> ActorClass)
+{
+	// walk class hierarchy only once per class
+	if (const bool* bCachedIsIgnored = IgnoredClassCache.Find(FObjectKey(ActorClass.Get())))
+	{
+		return *bCachedIsIgnored;
+	}
+
+	// if actor class is child or same class of any of ignored classes, return true, otherwise false
+	bool bIsIgnored = false;
+	for (const auto& IgnoredClass : IgnoredClasses)
+	{
+		if (ActorClass->IsChildOf(IgnoredClass))
+		{
+			bIsIgnored = true;
+			break;
+		}
+	}
+
+	IgnoredClassCache.Add(FObjectKey(ActorClass.Get()), bIsIgnored);
+	return bIsIgnored;
+}
+
+bool UCollisionHandlerComponent::IsIgnoredProfileName(FName ProfileName)
+{
+	return IgnoredProfileNameSet.Contains(ProfileName);
+}
+
+void UCollisionHandlerComponent::TraceCheckLoop()
+{
+	STARTERBUNDLE_SCOPE_CYCLE_COUNTER(STAT_TimerTraceCheck);
+
+	TraceCheckStep();
+}
+
+void UCollisionHandlerComponent::TraceCheckStep()
+{
+	if (ActiveStateMask == 0)
+	{
+		return;
+	}
+
+	UpdateFidelityTier(false);
+
+	// the lowest tier waits for the middle of activation, activation of unknown length is overlapped when it ends
+	const FCollisionFidelityTier* Tier = GetActiveFidelityTier();
+	if (Tier && Tier->bMidpointOverlapOnly)
+	{
+		if (bHasDoneMidpointOverlap == false && ActivationDuration > 0.f && GetWorld()->GetTimeSeconds() - ActivationStartTime >= 0.5f * ActivationDuration)
+		{
+			PerformMidpointOverlap();
+		}
+		return;
+	}
+
+	// steady state trace check is expected not to allocate, only hit processing may
+	STARTERBUNDLE_ALLOCATION_SCOPE(true);
+
+	SweepSegments.Reset();
+	CaptureSocketLocations.Reset();
+	CaptureSocketBounds.Init();
+
+	// samples are never evenly spaced, timer ticks with frames and adaptive interval changes, so arcs are fitted to real times of samples
+	const float Time = GetWorld()->GetTimeSeconds();
+	const float StepInterval = LastTraceCheckTime >= 0.f ? Time - LastTraceCheckTime : 0.f;
+	ArcIntervalRatio = StepInterval > KINDA_SMALL_NUMBER && LastStepInterval > KINDA_SMALL_NUMBER ? LastStepInterval / StepInterval : 1.f;
+	float MaxArcError = -1.f;
+
+	// sweeps of all active parts are gathered first, so they are traced in one pass in order of parts
+	for (uint32 Mask = ActiveStateMask; Mask != 0; Mask &= Mask - 1)
+	{
+		FCollisionPartState& Part = CollisionParts[FMath::CountTrailingZeros(Mask)];
+		if (Part.CollidingComponent == nullptr)
+		{
+			continue;
+		}
+
+		SampleSocketLocations(Part);
+
+		if (bIsCapturingActivation)
+		{
+			CaptureSocketLocations.Append(Part.CurrentSocketLocations);
+			for (const FVector& SocketLocation : Part.CurrentSocketLocations)
+			{
+				CaptureSocketBounds += SocketLocation;
+			}
+			for (const FVector& SocketLocation : Part.LastSocketLocations)
+			{
+				CaptureSocketBounds += SocketLocation;
+			}
+		}
+
+		// on first tick of part just update socket locations so on next tick it will be able to compare socket locations
+		if (Part.bCanPerformTrace)
+		{
+			// step that bent more than allowed error is split, so the error of its sweeps drops with square of number of sweeps
+			int32 NumArcSubsteps = ArcSubsteps;
+			if (bUseAdaptiveTraceInterval)
+			{
+				NumArcSubsteps = 1;
+				if (Part.bHasSecondLastSocketLocations)
+				{
+					const float ArcError = EstimateArcError(Part);
+					MaxArcError = FMath::Max(MaxArcError, ArcError);
+					NumArcSubsteps = FMath::Clamp(FMath::CeilToInt(FMath::Sqrt(ArcError / FMath::Max(MaxTraceDistanceError, KINDA_SMALL_NUMBER))), 1, MaxAdaptiveArcSubsteps);
+				}
+			}
+			GatherSweepSegments(Part, NumArcSubsteps);
+		}
+
+		UpdateSocketLocations(Part);
+		Part.bCanPerformTrace = true;
+	}
+
+	if (bIsCapturingActivation)
+	{
+		CaptureTrajectorySample();
+	}
+
+	if (bUseAdaptiveTraceInterval)
+	{
+		UpdateAdaptiveTraceInterval(MaxArcError, StepInterval);
+	}
+	LastTraceCheckTime = Time;
+	LastStepInterval = StepInterval;
+
+	PerformTraceCheck();
+}
+
+void UCollisionHandlerComponent::BeginTrajectoryCapture()
+{
+	// overlapping activation ends the previous one, so every activation in file has matching end
+	EndTrajectoryCapture();
+
+	UWorld* World = GetWorld();
+	UCollisionHandlerSubsystem* Subsystem = World ? World->GetSubsystem<UCollisionHandlerSubsystem>() : nullptr;
+	// sockets of all active parts are captured as one set, so every change of active parts starts new captured activation
+	int32 NumSockets = 0;
+	for (uint32 Mask = ActiveStateMask; Mask != 0; Mask &= Mask - 1)
+	{
+		const FCollisionPartState& Part = CollisionParts[FMath::CountTrailingZeros(Mask)];
+		NumSockets += Part.CollidingComponent ? Part.Sockets.Num() : 0;
+	}
+
+	if (Subsystem && Subsystem->OpenTrajectoryCapture())
+	{
+		Subsystem->GetTrajectoryWriter().WriteActivationBegin(GetUniqueID(), TraceRadius, NumSockets);
+		bIsCapturingActivation = true;
+	}
+}
+
+void UCollisionHandlerComponent::CaptureTrajectorySample()
+{
+	UWorld* World = GetWorld();
+	UCollisionHandlerSubsystem* Subsystem = World ? World->GetSubsystem<UCollisionHandlerSubsystem>() : nullptr;
+	if (Subsystem == nullptr)
+	{
+		return;
+	}
+
+	// targets near any socket, including ones which could be reached by sweep to the next sample
+	CaptureTargets.Reset();
+	Subsystem->QueryHurtboxes(CaptureSocketBounds.ExpandBy(TraceRadius + CollisionHandlerCapture::TargetMargin), CaptureTargets);
+	CaptureTargets.RemoveAllSwap([this, Subsystem](int32 OwnerIndex)
+	{
+		UHurtboxComponent* Hurtbox = Subsystem->GetHurtbox(OwnerIndex);
+		return Hurtbox == nullptr || Hurtbox->GetOwner() == GetOwner() || Hurtbox->GetHurtboxMesh() == nullptr;
+	}, false);
+
+	FCollisionTrajectoryWriter& TrajectoryWriter = Subsystem->GetTrajectoryWriter();
+	const FHurtboxCapsuleSet& HurtboxCapsules = Subsystem->GetHurtboxCapsules();
+	TrajectoryWriter.WriteSampleBegin(GetUniqueID(), World->GetTimeSeconds(), CaptureSocketLocations, CaptureTargets.Num());
+	for (int32 OwnerIndex : CaptureTargets)
+	{
+		UHurtboxComponent* Hurtbox = Subsystem->GetHurtbox(OwnerIndex);
+		int32 FirstCapsule, NumCapsules;
+		Subsystem->GetHurtboxCapsuleRange(OwnerIndex, FirstCapsule, NumCapsules);
+		TrajectoryWriter.WriteTarget(Hurtbox->GetOwner()->GetUniqueID(), Hurtbox->GetHurtboxMesh()->GetComponentTransform(), HurtboxCapsules, FirstCapsule, NumCapsules);
+	}
+}
+
+void UCollisionHandlerComponent::EndTrajectoryCapture()
+{
+	if (bIsCapturingActivation == false)
+	{
+		return;
+	}
+
+	bIsCapturingActivation = false;
+
+	UWorld* World = GetWorld();
+	if (UCollisionHandlerSubsystem* Subsystem = World ? World->GetSubsystem<UCollisionHandlerSubsystem>() : nullptr)
+	{
+		Subsystem->GetTrajectoryWriter().WriteActivationEnd(GetUniqueID());
+	}
+}
+
+void UCollisionHandlerComponent::TickBatchedTraceCheck(float DeltaTime, bool bDeferSweeps)
+{
+	bShouldDeferSweeps = bDeferSweeps;
+	AdvanceTraceCheck(DeltaTime);
+	bShouldDeferSweeps = false;
+}
+
+void UCollisionHandlerComponent::AdvanceTraceCheck(float DeltaTime)
+{
+	TraceCheckTimeAccumulator += DeltaTime;
+
+	if (TraceCheckTimeAccumulator >= CurrentTraceCheckInterval)
+	{
+		// check at most once per frame, looping timer would fire several times in a long frame and sweep the same socket locations
+		TraceCheckTimeAccumulator = CurrentTraceCheckInterval > 0.f ? FMath::Fmod(TraceCheckTimeAccumulator, CurrentTraceCheckInterval) : 0.f;
+
+		TraceCheckStep();
+	}
+}
+
+void UCollisionHandlerComponent::OnPoseUpdated()
+{
+	STARTERBUNDLE_SCOPE_CYCLE_COUNTER(STAT_PoseTraceCheck);
+
+	// bones can be finalized again in the same frame (e.g. by manual refresh), sockets are sampled only from the first pose of frame
+	UWorld* World = GetWorld();
+	if (World == nullptr || LastPoseUpdateFrame == GFrameCounter)
+	{
+		return;
+	}
+
+	const float Time = World->GetTimeSeconds();
+	const float DeltaTime = Time - LastPoseUpdateTime;
+	LastPoseUpdateTime = Time;
+	LastPoseUpdateFrame = GFrameCounter;
+
+	AdvanceTraceCheck(DeltaTime);
+}
+
+USkeletalMeshComponent* UCollisionHandlerComponent::FindPoseSourceMesh() const
+{
+	// weapons are usually attached to character mesh, so the first skeletal mesh up the attachment chain is the one moving them
+	for (uint32 Mask = ActiveStateMask; Mask != 0; Mask &= Mask - 1)
+	{
+		const FCollisionPartState& Part = CollisionParts[FMath::CountTrailingZeros(Mask)];
+		for (USceneComponent* Component = Part.CollidingComponent; Component; Component = Component->GetAttachParent())
+		{
+			if (USkeletalMeshComponent* Mesh = Cast<USkeletalMeshComponent>(Component))
+			{
+				return Mesh;
+			}
+		}
+	}
+	return nullptr;
+}
+
+void UCollisionHandlerComponent::UpdatePoseSource()
+{
+	if (bIsTraceCheckLoopRunning == false || bSampleOnPoseUpdate == false)
+	{
+		return;
+	}
+
+	USkeletalMeshComponent* NewPoseSourceMesh = FindPoseSourceMesh();
+	if (NewPoseSourceMesh == PoseSourceMesh)
+	{
+		return;
+	}
+
+	// mesh to mesh keeps timing of the loop, switching from or to subsystem or timer restarts it
+	if (NewPoseSourceMesh && PoseSourceMesh)
+	{
+		PoseSourceMesh->OnBoneTransformsFinalized.RemoveDynamic(this, &UCollisionHandlerComponent::OnPoseUpdated);
+		PoseSourceMesh = NewPoseSourceMesh;
+		PoseSourceMesh->OnBoneTransformsFinalized.AddUniqueDynamic(this, &UCollisionHandlerComponent::OnPoseUpdated);
+	}
+	else
+	{
+		StopTraceCheckLoop();
+		StartTraceCheckLoop();
+	}
+}
+
+FTransform UCollisionHandlerComponent::GetPoseComponentTransform(const USceneComponent* Component) const
+{
+	if (PoseSourceMesh == nullptr || Component == PoseSourceMesh)
+	{
+		return Component->GetComponentTransform();
+	}
+
+	// relative transforms are chained up to the mesh through component space socket transforms, which already follow new pose
+	FTransform ComponentToMesh = FTransform::Identity;
+	for (const USceneComponent* Child = Component; Child; Child = Child->GetAttachParent())
+	{
+		const USceneComponent* Parent = Child->GetAttachParent();
+		if (Parent == nullptr || Child->IsUsingAbsoluteLocation() || Child->IsUsingAbsoluteRotation() || Child->IsUsingAbsoluteScale())
+		{
+			break;
+		}
+
+		ComponentToMesh = ComponentToMesh * Child->GetRelativeTransform() * Parent->GetSocketTransform(Child->GetAttachSocketName(), RTS_Component);
+		if (Parent == PoseSourceMesh)
+		{
+			return ComponentToMesh * PoseSourceMesh->GetComponentTransform();
+		}
+	}
+
+	// not moved by pose source, its transform is up to date
+	return Component->GetComponentTransform();
+}
+
+void UCollisionHandlerComponent::StartTraceCheckLoop()
+{
+	UWorld* World = GetWorld();
+	if (World == nullptr)
+	{
+		return;
+	}
+
+	ResetTraceCheckInterval();
+
+	// handlers are counted here, so pose driven and timer driven loops are included
+	if (bIsTraceCheckLoopRunning == false)
+	{
+		bIsTraceCheckLoopRunning = true;
+		INC_DWORD_STAT(STAT_ActiveCollisionHandlers);
+	}
+
+	// samples follow pose updates, so every sample sees fresh bones and no pose is swept twice
+	PoseSourceMesh = bSampleOnPoseUpdate ? FindPoseSourceMesh() : nullptr;
+	if (PoseSourceMesh)
+	{
+		TraceCheckTimeAccumulator = 0.f;
+		LastPoseUpdateTime = World->GetTimeSeconds();
+		LastPoseUpdateFrame = MAX_uint64;
+		PoseSourceMesh->OnBoneTransformsFinalized.AddUniqueDynamic(this, &UCollisionHandlerComponent::OnPoseUpdated);
+		return;
+	}
+
+	UCollisionHandlerSubsystem* Subsystem = bUseBatchedTraceCheck ? World->GetSubsystem<UCollisionHandlerSubsystem>() : nullptr;
+	if (Subsystem)
+	{
+		TraceCheckTimeAccumulator = 0.f;
+		bIsRegisteredInSubsystem = true;
+		Subsystem->RegisterHandler(this);
+	}
+	else
+	{
+		// fallback, set timer which will check for collisions
+		World->GetTimerManager().SetTimer(TraceCheckTimerHandle, this, &UCollisionHandlerComponent::TraceCheckLoop, CurrentTraceCheckInterval, true);
+	}
+}
+
+void UCollisionHandlerComponent::StopTraceCheckLoop()
+{
+	if (bIsTraceCheckLoopRunning)
+	{
+		bIsTraceCheckLoopRunning = false;
+		DEC_DWORD_STAT(STAT_ActiveCollisionHandlers);
+	}
+
+	if (PoseSourceMesh)
+	{
+		PoseSourceMesh->OnBoneTransformsFinalized.RemoveDynamic(this, &UCollisionHandlerComponent::OnPoseUpdated);
+		PoseSourceMesh = nullptr;
+	}
+
+	UWorld* World = GetWorld();
+	if (World == nullptr)
+	{
+		return;
+	}
+
+	if (bIsRegisteredInSubsystem)
+	{
+		bIsRegisteredInSubsystem = false;
+		if (UCollisionHandlerSubsystem* Subsystem = World->GetSubsystem<UCollisionHandlerSubsystem>())
+		{
+			Subsystem->UnregisterHandler(this);
+		}
+	}
+
+	// clear timer checking for collision
+	World->GetTimerManager().ClearTimer(TraceCheckTimerHandle);
+}
+
+void UCollisionHandlerComponent::UpdateCollidingComponentAndSockets(UPrimitiveComponent* Component, const TArray<FName>& Sockets)
+{
+	RegisterCollisionPart(ECollisionPart::NONE, Component, Sockets);
+}
+
+void UCollisionHandlerComponent::RegisterCollisionPart(ECollisionPart CollisionPart, UPrimitiveComponent* Component, const TArray<FName>& Sockets)
+{
+	FCollisionPartState& Part = CollisionParts[(int32)CollisionPart];
+	Part.CollidingComponent = Component;
+	Part.Sockets = Sockets;
+
+	// default part is also exposed through CollidingComponent and CollisionSockets
+	if (CollisionPart == ECollisionPart::NONE)
+	{
+		CollidingComponent = Component;
+		CollisionSockets = Sockets;
+	}
+
+	// resolve sockets once so every sample avoids name lookups, history of previous sockets can't be compared anymore
+	ResolveSocketBindings(Part);
+	Part.bCanPerformTrace = false;
+	Part.BakedWindowIndex = INDEX_NONE;
+
+	// active part may now be traced by its own entry instead of default one
+	UpdateActiveStates();
+
+	// recorded sockets are laid out by registered parts, samples of previous layout can't be compared anymore
+	if (bRecordHistory && HasBegunPlay())
+	{
+		InitializeHistory();
+	}
+}
+
+void UCollisionHandlerComponent::UnregisterCollisionPart(ECollisionPart CollisionPart)
+{
+	RegisterCollisionPart(CollisionPart, nullptr, TArray<FName>());
+}
+
+int32 UCollisionHandlerComponent::GetPartStateIndex(ECollisionPart CollisionPart) const
+{
+	const int32 PartIndex = (int32)CollisionPart;
+	return CollisionParts[PartIndex].CollidingComponent ? PartIndex : (int32)ECollisionPart::NONE;
+}
+
+void UCollisionHandlerComponent::UpdateActiveStates()
+{
+	ActiveStateMask = 0;
+	for (uint32 Mask = ActivePartMask; Mask != 0; Mask &= Mask - 1)
+	{
+		ActiveStateMask |= 1u << GetPartStateIndex((ECollisionPart)FMath::CountTrailingZeros(Mask));
+	}
+
+	// parts may be moved by different mesh than the one loop follows
+	UpdatePoseSource();
+}
+
+void UCollisionHandlerComponent::ActivateCollision(ECollisionPart CollisionPart)
+{
+	// parts activated while collision is already active join the current activation, e.g. by overlapping notify windows
+	if (bIsCollisionActivated == false)
+	{
+		bIsCollisionActivated = true;
+		HitRegistry.Reset();
+		++ActivationId;
+
+		// owner is ignored once per activation
+		IgnoredActors.Reset();
+		IgnoredActors.Add(GetOwner());
+		CompileIgnoreRules();
+
+		// query params are built once here and only extended by IgnoreActor and IgnoreComponent until next activation
+		ActivationQueryParams = MakeQueryParams();
+		ActivationObjectQueryParams = FCollisionObjectQueryParams(ObjectTypesToCollideWith);
+		PrefilterIgnoreRules();
+
+		ActivationStartTime = GetWorld()->GetTimeSeconds();
+		ActivationDuration = PendingActivationDuration;
+		bHasDoneMidpointOverlap = false;
+
+		// tier is picked before loop starts, so its interval is used from the first step
+		UpdateFidelityTier(true);
+	}
+	PendingActivationDuration = 0.f;
+
+	const int32 StateIndex = GetPartStateIndex(CollisionPart);
+	FCollisionPartState& Part = CollisionParts[StateIndex];
+
+	// part that isn't traced yet starts sampling from scratch, parts sharing default entry keep sampling it
+	if ((ActiveStateMask & (1u << StateIndex)) == 0)
+	{
+		Part.bCanPerformTrace = false;
+
+		// mesh of colliding component could have been changed since sockets were resolved
+		if (Part.ResolvedMeshAsset.Get() != GetCollidingMeshAsset(Part) || Part.SocketBindings.Num() != Part.Sockets.Num())
+		{
+			ResolveSocketBindings(Part);
+		}
+	}
+
+	// trajectories are looked up once per activation, sockets are matched with baked window on first sample
+	Part.TrajectorySourceMesh = PendingTrajectorySourceMesh;
+	Part.TrajectorySourceMontage = Cast<UAnimMontage>(PendingTrajectorySourceAnimation.Get());
+	Part.BakedTrajectories = bUseBakedTrajectories ? UBakedSocketTrajectories::Get(Part.TrajectorySourceMontage) : nullptr;
+	Part.BakedWindowIndex = INDEX_NONE;
+	SetTrajectorySource(nullptr, nullptr);
+
+	const bool bWasTracing = ActiveStateMask != 0;
+	++PartActivationCounts[(int32)CollisionPart];
+	ActivePartMask |= 1u << (uint32)CollisionPart;
+	ActivatedCollisionPart = CollisionPart;
+	UpdateActiveStates();
+
+	if (bCaptureTrajectory)
+	{
+		BeginTrajectoryCapture();
+	}
+
+	// start checking for collisions, batched in subsystem or on timer
+	if (bWasTracing == false)
+	{
+		StartTraceCheckLoop();
+	}
+	
+	// call OnCollisionActivated delegates
+	NotifyOnCollisionActivated(CollisionPart);
+}
+
+void UCollisionHandlerComponent::DeactivateCollisionPart(ECollisionPart CollisionPart)
+{
+	const uint32 PartBit = 1u << (uint32)CollisionPart;
+	if ((ActivePartMask & PartBit) == 0)
+	{
+		return;
+	}
+
+	// overlapping windows of the same part keep it active until the last one ends
+	if (--PartActivationCounts[(int32)CollisionPart] > 0)
+	{
+		return;
+	}
+
+	// last active part ends the whole activation
+	if (ActivePartMask == PartBit)
+	{
+		DeactivateCollision();
+		return;
+	}
+
+	const uint32 PreviousStateMask = ActiveStateMask;
+	ActivePartMask &= ~PartBit;
+	UpdateActiveStates();
+
+	// entry may still be traced by another part sharing it
+	const int32 StateIndex = GetPartStateIndex(CollisionPart);
+	if ((ActiveStateMask & (1u << StateIndex)) == 0)
+	{
+		FCollisionPartState& Part = CollisionParts[StateIndex];
+		Part.TrajectorySourceMesh = nullptr;
+		Part.TrajectorySourceMontage = nullptr;
+		Part.BakedTrajectories = nullptr;
+	}
+
+	if (ActivatedCollisionPart == CollisionPart)
+	{
+		ActivatedCollisionPart = (ECollisionPart)FMath::CountTrailingZeros(ActivePartMask);
+	}
+
+	if (bIsCapturingActivation && PreviousStateMask != ActiveStateMask)
+	{
+		BeginTrajectoryCapture();
+	}
+}
+
+void UCollisionHandlerComponent::DeactivateCollision()
+{
+	// the lowest tier overlaps activation that ended before its middle was reached or had unknown length
+	const FCollisionFidelityTier* Tier = GetActiveFidelityTier();
+	if (bIsCollisionActivated && Tier && Tier->bMidpointOverlapOnly && bHasDoneMidpointOverlap == false)
+	{
+		PerformMidpointOverlap();
+	}
+
+	bIsCollisionActivated = false;
+	bHasDeferredSweeps = false;
+	
+	// stop checking for collisions
+	StopTraceCheckLoop();
+
+	EndTrajectoryCapture();
+
+	// source is set again by next notify, activations from Blueprint use live pose
+	for (uint32 Mask = ActiveStateMask; Mask != 0; Mask &= Mask - 1)
+	{
+		FCollisionPartState& Part = CollisionParts[FMath::CountTrailingZeros(Mask)];
+		Part.bCanPerformTrace = false;
+		Part.TrajectorySourceMesh = nullptr;
+		Part.TrajectorySourceMontage = nullptr;
+		Part.BakedTrajectories = nullptr;
+	}
+
+	ActivePartMask = 0;
+	ActiveStateMask = 0;
+	ActivatedCollisionPart = ECollisionPart::NONE;
+	FMemory::Memzero(PartActivationCounts.GetData(), PartActivationCounts.Num() * sizeof(uint16));
+
+	// call OnCollisionDeactivated delegates
+	NotifyOnCollisionDeactivated();
+}
+
+void UCollisionHandlerComponent::SetActivationDuration(float Duration)
+{
+	PendingActivationDuration = Duration;
+}
+
+void UCollisionHandlerComponent::SetTrajectorySource(USkeletalMeshComponent* Mesh, UAnimSequenceBase* Animation)
+{
+	PendingTrajectorySourceMesh = Mesh;
+	PendingTrajectorySourceAnimation = Animation;
+}
+
+bool UCollisionHandlerComponent::IsCollisionPartActivated(ECollisionPart CollisionPart) const
+{
+	return (ActivePartMask & (1u << (uint32)CollisionPart)) != 0;
+}
+
+TArray<FName> UCollisionHandlerComponent::GetCollisionSockets() const
+{
+	return CollisionSockets;
+}
+
+UPrimitiveComponent* UCollisionHandlerComponent::GetCollidingComponent() const
+{
+	return CollidingComponent;
+}
+
+bool UCollisionHandlerComponent::IsCollisionActivated() const
+{
+	return bIsCollisionActivated;
+}
+
+ECollisionPart UCollisionHandlerComponent::GetActivatedCollisionPart() const
+{
+	return ActivatedCollisionPart;
+}
+
+void UCollisionHandlerComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	if (bRecordHistory)
+	{
+		RecordHistorySample();
+	}
+}
+
+int32 UCollisionHandlerComponent::GetNumHistorySockets() const
+{
+	int32 NumSockets = 0;
+	for (const FCollisionPartState& Part : CollisionParts)
+	{
+		if (Part.CollidingComponent)
+		{
+			NumSockets += Part.Sockets.Num();
+		}
+	}
+	return NumSockets;
+}
+
+void UCollisionHandlerComponent::InitializeHistory()
+{
+	const int32 NumSockets = GetNumHistorySockets();
+	const int32 Capacity = FMath::CeilToInt(HistoryDuration / FMath::Max(HistorySampleInterval, KINDA_SMALL_NUMBER)) + 1;
+
+	DEC_MEMORY_STAT_BY(STAT_HitHistoryMemory, History.GetAllocatedSize());
+	History.Initialize(NumSockets, Capacity);
+	INC_MEMORY_STAT_BY(STAT_HitHistoryMemory, History.GetAllocatedSize());
+
+	HistorySocketLocations.Reset(NumSockets);
+}
+
+void UCollisionHandlerComponent::RecordHistorySample()
+{
+	if (GetNumHistorySockets() != History.GetNumSockets())
+	{
+		InitializeHistory();
+	}
+
+	// sockets of every registered part are appended in part order, so each part starts at sum of sockets of parts before it,
+	// current socket locations of parts are scratch between trace checks, so they can be reused here
+	HistorySocketLocations.Reset();
+	for (FCollisionPartState& Part : CollisionParts)
+	{
+		if (Part.CollidingComponent && Part.Sockets.Num() > 0)
+		{
+			SampleSocketLocations(Part);
+			HistorySocketLocations.Append(Part.CurrentSocketLocations);
+		}
+	}
+
+	History.Record(GetWorld()->GetTimeSeconds(), HistorySocketLocations, GetOwner()->GetActorTransform());
+}
+
+bool UCollisionHandlerComponent::ValidateHitAtTime(const UCollisionHandlerComponent* Target, float ClientTime) const
+{
+	if (Target == nullptr || History.GetNumSockets() == 0)
+	{
+		return false;
+	}
+
+	// rewind both ends of socket sweeps and target hurtbox
+	int32 StartOlder, StartNewer, EndOlder, EndNewer, TargetOlder, TargetNewer;
+	float StartAlpha, EndAlpha, TargetAlpha;
+	if (History.FindSamples(ClientTime - HistorySampleInterval, StartOlder, StartNewer, StartAlpha) == false ||
+		History.FindSamples(ClientTime, EndOlder, EndNewer, EndAlpha) == false ||
+		Target->History.FindSamples(ClientTime, TargetOlder, TargetNewer, TargetAlpha) == false)
+	{
+		return false;
+	}
+
+	// hurtbox capsule as segment between centers of its hemispheres
+	const FTransform Hurtbox = Target->History.GetHurtboxTransform(TargetOlder, TargetNewer, TargetAlpha);
+	const FVector CapsuleAxis = Hurtbox.GetUnitAxis(EAxis::Z) * FMath::Max(Target->HurtboxHalfHeight - Target->HurtboxRadius, 0.f);
+	const FVector CapsuleTop = Hurtbox.GetLocation() + CapsuleAxis;
+	const FVector CapsuleBottom = Hurtbox.GetLocation() - CapsuleAxis;
+	const float MaxDistance = TraceRadius + Target->HurtboxRadius + ValidationTolerance;
+
+	for (int32 SocketIndex = 0; SocketIndex < History.GetNumSockets(); ++SocketIndex)
+	{
+		const FVector SweepStart = History.GetSocketLocation(StartOlder, StartNewer, StartAlpha, SocketIndex);
+		const FVector SweepEnd = History.GetSocketLocation(EndOlder, EndNewer, EndAlpha, SocketIndex);
+
+		FVector SweepPoint, CapsulePoint;
+		FMath::SegmentDistToSegmentSafe(SweepStart, SweepEnd, CapsuleTop, CapsuleBottom, SweepPoint, CapsulePoint);
+		if (FVector::DistSquared(SweepPoint, CapsulePoint) <= FMath::Square(MaxDistance))
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+int32 UCollisionHandlerComponent::GetHistoryMemoryBytes() const
+{
+	return (int32)History.GetAllocatedSize();
+}
+
+int64 UCollisionHandlerComponent::GetNumSweepsIssued() const
+{
+	return NumSweepsIssued;
 }
 
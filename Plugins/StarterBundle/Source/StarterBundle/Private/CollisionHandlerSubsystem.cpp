@@ -0,0 +1,347 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "CollisionHandlerSubsystem.h"
+#include "CollisionHandlerComponent.h"
+#include "HurtboxComponent.h"
+#include "StarterBundleStats.h"
+#include "Async/ParallelFor.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "GameFramework/Pawn.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/DateTime.h"
+#include "Misc/Paths.h"
+
+namespace CollisionHandlerSubsystemCommands
+{
+	static FAutoConsoleCommandWithWorldAndArgs DumpTraceRecordsCommand(
+		TEXT("StarterBundle.DumpTraceRecords"),
+		TEXT("Writes collision handler trace records of current world to binary file. Usage: StarterBundle.DumpTraceRecords [Filename]"),
+		FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+		{
+			if (UCollisionHandlerSubsystem* Subsystem = World ? World->GetSubsystem<UCollisionHandlerSubsystem>() : nullptr)
+			{
+				Subsystem->DumpTraceRecords(Args.Num() > 0 ? Args[0] : FString());
+			}
+		}));
+}
+
+void UCollisionHandlerSubsystem::Deinitialize()
+{
+	ActiveHandlers.Empty();
+	HandlersWithPendingHits.Empty();
+	DeferredSweepHandlers.Empty();
+	Hurtboxes.Empty();
+	HurtboxCapsules.Reset();
+	HurtboxGrid.Reset();
+	TrajectoryWriter.Close();
+
+	Super::Deinitialize();
+}
+
+void UCollisionHandlerSubsystem::Tick(float DeltaTime)
+{
+	STARTERBUNDLE_SCOPE_CYCLE_COUNTER(STAT_BatchedTraceCheck);
+
+	bIsProcessingHandlers = true;
+
+	// handlers registered during the pass are appended and processed in the same pass
+	const bool bDeferSweeps = NumParallelTraceWorkers > 0;
+	for (int32 Index = 0; Index < ActiveHandlers.Num(); ++Index)
+	{
+		UCollisionHandlerComponent* Handler = ActiveHandlers[Index];
+		if (Handler)
+		{
+			Handler->TickBatchedTraceCheck(DeltaTime, bDeferSweeps);
+			if (Handler->HasDeferredSweeps())
+			{
+				DeferredSweepHandlers.Add(Handler);
+			}
+		}
+	}
+
+	// deferred sweeps start once every handler has sampled its sockets, their hits are merged before batched dispatch
+	PerformDeferredSweeps();
+
+	bIsProcessingHandlers = false;
+
+	// compact slots of handlers unregistered during the pass
+	if (bHasPendingRemovals)
+	{
+		ActiveHandlers.Remove(nullptr);
+		bHasPendingRemovals = false;
+	}
+
+	// hits of sync, timer and async trace checks of this frame are delivered together after all sweeps are done
+	DispatchPendingHits();
+}
+
+bool UCollisionHandlerSubsystem::IsTickable() const
+{
+	return ActiveHandlers.Num() > 0 || HandlersWithPendingHits.Num() > 0;
+}
+
+TStatId UCollisionHandlerSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UCollisionHandlerSubsystem, STATGROUP_Tickables);
+}
+
+UWorld* UCollisionHandlerSubsystem::GetTickableGameObjectWorld() const
+{
+	return GetWorld();
+}
+
+void UCollisionHandlerSubsystem::RegisterHandler(UCollisionHandlerComponent* Handler)
+{
+	if (Handler && ActiveHandlers.Contains(Handler) == false)
+	{
+		ActiveHandlers.Add(Handler);
+	}
+}
+
+void UCollisionHandlerSubsystem::UnregisterHandler(UCollisionHandlerComponent* Handler)
+{
+	const int32 Index = ActiveHandlers.Find(Handler);
+	if (Handler && Index != INDEX_NONE)
+	{
+		// while the pass is running only clear the slot so indices of remaining handlers stay valid
+		if (bIsProcessingHandlers)
+		{
+			ActiveHandlers[Index] = nullptr;
+			bHasPendingRemovals = true;
+		}
+		else
+		{
+			ActiveHandlers.RemoveAt(Index);
+		}
+	}
+}
+
+int32 UCollisionHandlerSubsystem::GetNumActiveHandlers() const
+{
+	return ActiveHandlers.Num();
+}
+
+void UCollisionHandlerSubsystem::SetNumParallelTraceWorkers(int32 NumWorkers)
+{
+	NumParallelTraceWorkers = FMath::Max(NumWorkers, 0);
+}
+
+void UCollisionHandlerSubsystem::PerformDeferredSweeps()
+{
+	if (DeferredSweepHandlers.Num() == 0)
+	{
+		return;
+	}
+
+	{
+		STARTERBUNDLE_SCOPE_CYCLE_COUNTER(STAT_ParallelSweeps);
+
+		// capsules tested by hurtbox narrowphase are posed before workers start, workers only read them
+		if (Hurtboxes.Num() > 0)
+		{
+			UpdateHurtboxes();
+		}
+
+		// one task per contiguous chunk of handlers, so number of chunks limits number of threads sweeping at once
+		const int32 NumHandlers = DeferredSweepHandlers.Num();
+		const int32 NumChunks = FMath::Clamp(NumParallelTraceWorkers, 1, NumHandlers);
+		const int32 ChunkSize = FMath::DivideAndRoundUp(NumHandlers, NumChunks);
+		ParallelFor(NumChunks, [this, NumHandlers, ChunkSize](int32 ChunkIndex)
+		{
+			const int32 EndIndex = FMath::Min((ChunkIndex + 1) * ChunkSize, NumHandlers);
+			for (int32 Index = ChunkIndex * ChunkSize; Index < EndIndex; ++Index)
+			{
+				DeferredSweepHandlers[Index]->PerformDeferredSweeps();
+			}
+		}, NumChunks == 1);
+	}
+
+	// hits are processed in order of handlers whatever thread swept them, so gameplay sees the same order every run
+	for (UCollisionHandlerComponent* Handler : DeferredSweepHandlers)
+	{
+		if (Handler)
+		{
+			Handler->MergeDeferredSweeps();
+		}
+	}
+	DeferredSweepHandlers.Reset();
+}
+
+void UCollisionHandlerSubsystem::QueueHitDispatch(UCollisionHandlerComponent* Handler)
+{
+	if (Handler)
+	{
+		HandlersWithPendingHits.Add(Handler);
+	}
+}
+
+void UCollisionHandlerSubsystem::DispatchPendingHits()
+{
+	if (HandlersWithPendingHits.Num() == 0)
+	{
+		return;
+	}
+
+	Exchange(HandlersWithPendingHits, DispatchingHandlers);
+	for (UCollisionHandlerComponent* Handler : DispatchingHandlers)
+	{
+		if (Handler)
+		{
+			Handler->DispatchPendingHits();
+		}
+	}
+	DispatchingHandlers.Reset();
+}
+
+void UCollisionHandlerSubsystem::RegisterHurtbox(UHurtboxComponent* Hurtbox)
+{
+	if (Hurtbox && Hurtboxes.Contains(Hurtbox) == false)
+	{
+		Hurtboxes.Add(Hurtbox);
+		HurtboxCapsulesFrame = MAX_uint64;
+	}
+}
+
+void UCollisionHandlerSubsystem::UnregisterHurtbox(UHurtboxComponent* Hurtbox)
+{
+	// owner indices of remaining hurtboxes change, so capsules are rebuilt on next request
+	if (Hurtboxes.Remove(Hurtbox) > 0)
+	{
+		HurtboxCapsulesFrame = MAX_uint64;
+	}
+}
+
+const FHurtboxCapsuleSet& UCollisionHandlerSubsystem::GetHurtboxCapsules()
+{
+	UpdateHurtboxes();
+	return HurtboxCapsules;
+}
+
+UHurtboxComponent* UCollisionHandlerSubsystem::GetHurtbox(int32 OwnerIndex) const
+{
+	return Hurtboxes.IsValidIndex(OwnerIndex) ? Hurtboxes[OwnerIndex] : nullptr;
+}
+
+void UCollisionHandlerSubsystem::QueryHurtboxes(const FBox& Bounds, TArray<int32>& OutOwnerIndices)
+{
+	UpdateHurtboxes();
+	HurtboxGrid.Query(Bounds, OutOwnerIndices);
+}
+
+void UCollisionHandlerSubsystem::GetHurtboxCapsuleRange(int32 OwnerIndex, int32& OutFirstCapsule, int32& OutNumCapsules) const
+{
+	const bool bIsValid = HurtboxFirstCapsules.IsValidIndex(OwnerIndex);
+	OutFirstCapsule = bIsValid ? HurtboxFirstCapsules[OwnerIndex] : 0;
+	OutNumCapsules = bIsValid ? HurtboxNumCapsules[OwnerIndex] : 0;
+}
+
+void UCollisionHandlerSubsystem::SetHurtboxCellSize(float NewCellSize)
+{
+	HurtboxCellSize = NewCellSize;
+	HurtboxCapsulesFrame = MAX_uint64;
+}
+
+void UCollisionHandlerSubsystem::UpdateHurtboxes()
+{
+	if (HurtboxCapsulesFrame == GFrameCounter)
+	{
+		return;
+	}
+
+	STARTERBUNDLE_SCOPE_CYCLE_COUNTER(STAT_UpdateHurtboxes);
+
+	HurtboxCapsules.Reset();
+	HurtboxFirstCapsules.SetNumUninitialized(Hurtboxes.Num(), false);
+	HurtboxNumCapsules.SetNumUninitialized(Hurtboxes.Num(), false);
+	HurtboxBounds.SetNumUninitialized(Hurtboxes.Num(), false);
+
+	// capsules of every hurtbox are contiguous, so narrowphase can test single broadphase candidate
+	for (int32 Index = 0; Index < Hurtboxes.Num(); ++Index)
+	{
+		const int32 FirstCapsule = HurtboxCapsules.Num();
+		if (Hurtboxes[Index])
+		{
+			Hurtboxes[Index]->AppendWorldCapsules(HurtboxCapsules, Index);
+		}
+
+		FBox Bounds(ForceInit);
+		for (int32 CapsuleIndex = FirstCapsule; CapsuleIndex < HurtboxCapsules.Num(); ++CapsuleIndex)
+		{
+			const FVector Extent(HurtboxCapsules.GetRadius(CapsuleIndex));
+			Bounds += FBox(HurtboxCapsules.GetStart(CapsuleIndex) - Extent, HurtboxCapsules.GetStart(CapsuleIndex) + Extent);
+			Bounds += FBox(HurtboxCapsules.GetEnd(CapsuleIndex) - Extent, HurtboxCapsules.GetEnd(CapsuleIndex) + Extent);
+		}
+
+		HurtboxFirstCapsules[Index] = FirstCapsule;
+		HurtboxNumCapsules[Index] = HurtboxCapsules.Num() - FirstCapsule;
+		HurtboxBounds[Index] = Bounds;
+	}
+
+	HurtboxGrid.Build(HurtboxBounds, HurtboxCellSize > 0.f ? HurtboxCellSize : HurtboxGrid.GetCellSize());
+	HurtboxCapsulesFrame = GFrameCounter;
+}
+
+const TArray<FVector>& UCollisionHandlerSubsystem::GetPlayerLocations()
+{
+	if (PlayerLocationsFrame == GFrameCounter)
+	{
+		return PlayerLocations;
+	}
+
+	// server has controller of every connected player, client only of local ones
+	PlayerLocations.Reset();
+	for (FConstPlayerControllerIterator Iterator = GetWorld()->GetPlayerControllerIterator(); Iterator; ++Iterator)
+	{
+		const APlayerController* PlayerController = Iterator->Get();
+		if (PlayerController == nullptr)
+		{
+			continue;
+		}
+
+		if (const APawn* Pawn = PlayerController->GetPawn())
+		{
+			PlayerLocations.Add(Pawn->GetActorLocation());
+		}
+		else
+		{
+			FVector ViewLocation;
+			FRotator ViewRotation;
+			PlayerController->GetPlayerViewPoint(ViewLocation, ViewRotation);
+			PlayerLocations.Add(ViewLocation);
+		}
+	}
+
+	PlayerLocationsFrame = GFrameCounter;
+	return PlayerLocations;
+}
+
+void UCollisionHandlerSubsystem::SetTraceRecorderCapacity(int32 Capacity)
+{
+	TraceRecorder.SetCapacity(Capacity);
+}
+
+bool UCollisionHandlerSubsystem::DumpTraceRecords(const FString& Filename)
+{
+	const FString OutputFilename = Filename.IsEmpty()
+		? FPaths::ProjectSavedDir() / TEXT("CollisionTraces") / FString::Printf(TEXT("%s_%s.sbtrace"), *GetWorld()->GetMapName(), *FDateTime::Now().ToString())
+		: Filename;
+
+	return TraceRecorder.SaveToFile(OutputFilename);
+}
+
+bool UCollisionHandlerSubsystem::OpenTrajectoryCapture()
+{
+	if (TrajectoryWriter.IsOpen() == false)
+	{
+		const FString Filename = FPaths::ProjectSavedDir() / TEXT("CollisionTrajectories") / FString::Printf(TEXT("%s_%s.sbtraj"), *GetWorld()->GetMapName(), *FDateTime::Now().ToString());
+		TrajectoryWriter.Open(Filename);
+	}
+	return TrajectoryWriter.IsOpen();
+}
+
+void UCollisionHandlerSubsystem::CloseTrajectoryCapture()
+{
+	TrajectoryWriter.Close();
+}
@@ -0,0 +1,105 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "CollisionHistoryBuffer.h"
+
+FCollisionHistoryBuffer::FCollisionHistoryBuffer()
+	: NumSockets(0), Capacity(0), Head(0), NumSamples(0)
+{
+}
+
+void FCollisionHistoryBuffer::Initialize(int32 InNumSockets, int32 InCapacity)
+{
+	NumSockets = FMath::Max(InNumSockets, 0);
+	Capacity = FMath::Max(InCapacity, 0);
+
+	// exact sizes, so memory per handler is bounded and known
+	SampleTimes.Empty(Capacity);
+	SampleTimes.SetNumZeroed(Capacity);
+	SocketLocations.Empty(Capacity * NumSockets);
+	SocketLocations.SetNumZeroed(Capacity * NumSockets);
+	HurtboxTransforms.Empty(Capacity);
+	HurtboxTransforms.SetNum(Capacity);
+
+	Reset();
+}
+
+void FCollisionHistoryBuffer::Reset()
+{
+	Head = 0;
+	NumSamples = 0;
+}
+
+void FCollisionHistoryBuffer::Record(float Time, const TArray<FVector>& InSocketLocations, const FTransform& HurtboxTransform)
+{
+	if (Capacity == 0 || InSocketLocations.Num() < NumSockets)
+	{
+		return;
+	}
+
+	SampleTimes[Head] = Time;
+	HurtboxTransforms[Head] = HurtboxTransform;
+	if (NumSockets > 0)
+	{
+		FMemory::Memcpy(&SocketLocations[Head * NumSockets], InSocketLocations.GetData(), NumSockets * sizeof(FVector));
+	}
+
+	Head = (Head + 1) % Capacity;
+	NumSamples = FMath::Min(NumSamples + 1, Capacity);
+}
+
+bool FCollisionHistoryBuffer::FindSamples(float Time, int32& OutOlderSample, int32& OutNewerSample, float& OutAlpha) const
+{
+	if (NumSamples == 0 || Time < SampleTimes[GetStorageIndex(0)])
+	{
+		return false;
+	}
+
+	// walk from the newest sample, rewinds are usually short
+	for (int32 Sample = NumSamples - 1; Sample >= 0; --Sample)
+	{
+		const int32 StorageIndex = GetStorageIndex(Sample);
+		if (SampleTimes[StorageIndex] <= Time)
+		{
+			OutOlderSample = StorageIndex;
+			if (Sample == NumSamples - 1)
+			{
+				OutNewerSample = StorageIndex;
+				OutAlpha = 0.f;
+			}
+			else
+			{
+				OutNewerSample = GetStorageIndex(Sample + 1);
+				const float SampleDuration = SampleTimes[OutNewerSample] - SampleTimes[OutOlderSample];
+				OutAlpha = SampleDuration > 0.f ? (Time - SampleTimes[OutOlderSample]) / SampleDuration : 0.f;
+			}
+			return true;
+		}
+	}
+
+	return false;
+}
+
+FVector FCollisionHistoryBuffer::GetSocketLocation(int32 OlderSample, int32 NewerSample, float Alpha, int32 SocketIndex) const
+{
+	const FVector& OlderLocation = SocketLocations[OlderSample * NumSockets + SocketIndex];
+	const FVector& NewerLocation = SocketLocations[NewerSample * NumSockets + SocketIndex];
+	return FMath::Lerp(OlderLocation, NewerLocation, Alpha);
+}
+
+FTransform FCollisionHistoryBuffer::GetHurtboxTransform(int32 OlderSample, int32 NewerSample, float Alpha) const
+{
+	FTransform Result;
+	Result.Blend(HurtboxTransforms[OlderSample], HurtboxTransforms[NewerSample], Alpha);
+	return Result;
+}
+
+SIZE_T FCollisionHistoryBuffer::GetAllocatedSize() const
+{
+	return SampleTimes.GetAllocatedSize() + SocketLocations.GetAllocatedSize() + HurtboxTransforms.GetAllocatedSize();
+}
+
+int32 FCollisionHistoryBuffer::GetStorageIndex(int32 Sample) const
+{
+	return (Head - NumSamples + Sample + Capacity) % Capacity;
+}
@@ -0,0 +1,74 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "CollisionHitRegistry.h"
+#include "GameFramework/Actor.h"
+
+void FCollisionHitRegistry::Reset()
+{
+	Records.Reset();
+}
+
+bool FCollisionHitRegistry::TryRegisterHit(const AActor* Actor, float Time, const FCollisionRehitSettings& Settings)
+{
+	if (Actor == nullptr)
+	{
+		return false;
+	}
+
+	FHitRecord* Record = Records.Find(FObjectKey(Actor));
+	if (Record == nullptr)
+	{
+		// first hit of this actor
+		FHitRecord& NewRecord = Records.Add(FObjectKey(Actor));
+		NewRecord.LastHitTime = Time;
+		NewRecord.WindowStartTime = Time;
+		NewRecord.WindowHitCount = 1;
+		return true;
+	}
+
+	// merge hits of the same trace check
+	if (Record->LastHitTime == Time)
+	{
+		return false;
+	}
+
+	switch (Settings.Policy)
+	{
+	case ECollisionRehitPolicy::RehitAfterCooldown:
+		if (Time - Record->LastHitTime < Settings.RehitCooldown)
+		{
+			return false;
+		}
+		break;
+
+	case ECollisionRehitPolicy::MaxHitsPerWindow:
+		if (Time - Record->WindowStartTime >= Settings.HitWindowDuration)
+		{
+			Record->WindowStartTime = Time;
+			Record->WindowHitCount = 0;
+		}
+		if (Record->WindowHitCount >= Settings.MaxHitsPerWindow)
+		{
+			return false;
+		}
+		++Record->WindowHitCount;
+		break;
+
+	default:
+		return false;
+	}
+
+	Record->LastHitTime = Time;
+	return true;
+}
+
+bool FCollisionHitRegistry::WasHit(const AActor* Actor) const
+{
+	return Records.Contains(FObjectKey(Actor));
+}
+
+int32 FCollisionHitRegistry::Num() const
+{
+	return Records.Num();
+}
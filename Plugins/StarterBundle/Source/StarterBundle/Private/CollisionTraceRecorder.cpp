@@ -0,0 +1,145 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "CollisionTraceRecorder.h"
+#include "HAL/FileManager.h"
+#include "Serialization/Archive.h"
+#include "VisualLogger/VisualLogger.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogCollisionTraceRecorder, Log, All);
+
+namespace CollisionTraceRecorderFile
+{
+	/* "SBTR" */
+	static const uint32 Magic = 0x52544253;
+	static const uint32 Version = 1;
+}
+
+FArchive& operator<<(FArchive& Ar, FCollisionTraceRecord& Record)
+{
+	Ar << Record.Start;
+	Ar << Record.End;
+	Ar << Record.Radius;
+	Ar << Record.HalfHeight;
+	Ar << Record.Frame;
+	Ar << Record.HandlerId;
+	Ar << Record.bHit;
+	return Ar;
+}
+
+FCollisionTraceRecorder::FCollisionTraceRecorder()
+	: Capacity(16384),
+	Head(0),
+	NumRecords(0)
+{
+}
+
+void FCollisionTraceRecorder::SetCapacity(int32 InCapacity)
+{
+	Capacity = FMath::Max(InCapacity, 1);
+	Records.Empty();
+	Reset();
+}
+
+void FCollisionTraceRecorder::Reset()
+{
+	Head = 0;
+	NumRecords = 0;
+}
+
+void FCollisionTraceRecorder::Record(const FCollisionTraceRecord& TraceRecord, const UObject* VisLogOwner)
+{
+	if (Records.Num() != Capacity)
+	{
+		Records.SetNumUninitialized(Capacity);
+	}
+
+	Records[Head] = TraceRecord;
+	Head = (Head + 1) % Capacity;
+	NumRecords = FMath::Min(NumRecords + 1, Capacity);
+
+#if ENABLE_VISUAL_LOG
+	if (VisLogOwner && FVisualLogger::IsRecording())
+	{
+		const FColor Color = TraceRecord.bHit ? FColor::Green : FColor::Red;
+		UE_VLOG_SEGMENT_THICK(VisLogOwner, LogCollisionTraceRecorder, Verbose, TraceRecord.Start, TraceRecord.End, Color, 2, TEXT("%s"), TraceRecord.bHit ? TEXT("Hit") : TEXT(""));
+		UE_VLOG_LOCATION(VisLogOwner, LogCollisionTraceRecorder, Verbose, TraceRecord.End, TraceRecord.Radius + TraceRecord.HalfHeight, Color, TEXT(""));
+	}
+#endif
+}
+
+const FCollisionTraceRecord& FCollisionTraceRecorder::Get(int32 Index) const
+{
+	check(Index >= 0 && Index < NumRecords);
+	return Records[(Head - NumRecords + Index + Capacity) % Capacity];
+}
+
+bool FCollisionTraceRecorder::SaveToFile(const FString& Filename) const
+{
+	TUniquePtr<FArchive> Writer(IFileManager::Get().CreateFileWriter(*Filename));
+	if (Writer.IsValid() == false)
+	{
+		UE_LOG(LogCollisionTraceRecorder, Warning, TEXT("Couldn't open %s for writing"), *Filename);
+		return false;
+	}
+
+	uint32 Magic = CollisionTraceRecorderFile::Magic;
+	uint32 Version = CollisionTraceRecorderFile::Version;
+	int32 NumToWrite = NumRecords;
+	*Writer << Magic;
+	*Writer << Version;
+	*Writer << NumToWrite;
+
+	for (int32 Index = 0; Index < NumRecords; ++Index)
+	{
+		FCollisionTraceRecord TraceRecord = Get(Index);
+		*Writer << TraceRecord;
+	}
+
+	UE_LOG(LogCollisionTraceRecorder, Display, TEXT("Saved %d trace records to %s"), NumRecords, *Filename);
+	return Writer->Close();
+}
+
+bool FCollisionTraceRecorder::LoadFromFile(const FString& Filename, TArray<FCollisionTraceRecord>& OutRecords)
+{
+	TUniquePtr<FArchive> Reader(IFileManager::Get().CreateFileReader(*Filename));
+	if (Reader.IsValid() == false)
+	{
+		return false;
+	}
+
+	uint32 Magic = 0;
+	uint32 Version = 0;
+	int32 NumToRead = 0;
+	*Reader << Magic;
+	*Reader << Version;
+	*Reader << NumToRead;
+	if (Reader->IsError() || Magic != CollisionTraceRecorderFile::Magic || Version != CollisionTraceRecorderFile::Version || NumToRead < 0)
+	{
+		UE_LOG(LogCollisionTraceRecorder, Warning, TEXT("%s is not a trace record file"), *Filename);
+		return false;
+	}
+
+	// count comes from file, so memory isn't reserved up front
+	OutRecords.Reset();
+	for (int32 Index = 0; Index < NumToRead && Reader->AtEnd() == false; ++Index)
+	{
+		FCollisionTraceRecord TraceRecord;
+		*Reader << TraceRecord;
+
+		// truncated record is dropped, records read before it are kept
+		if (Reader->IsError())
+		{
+			UE_LOG(LogCollisionTraceRecorder, Warning, TEXT("%s is truncated, read %d of %d records"), *Filename, OutRecords.Num(), NumToRead);
+			break;
+		}
+		OutRecords.Add(TraceRecord);
+	}
+
+	return Reader->Close();
+}
+
+SIZE_T FCollisionTraceRecorder::GetAllocatedSize() const
+{
+	return Records.GetAllocatedSize();
+}
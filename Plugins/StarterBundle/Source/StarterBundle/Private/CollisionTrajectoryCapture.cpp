@@ -0,0 +1,257 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "CollisionTrajectoryCapture.h"
+#include "HurtboxCapsuleSet.h"
+#include "HAL/FileManager.h"
+#include "Serialization/Archive.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogCollisionTrajectoryCapture, Log, All);
+
+namespace CollisionTrajectoryFile
+{
+	/* "SBTJ" */
+	static const uint32 Magic = 0x4A544253;
+	static const uint32 Version = 1;
+
+	/* Type of every record following the header */
+	enum ERecordType : uint8
+	{
+		ActivationBegin = 1,
+		Sample = 2,
+		ActivationEnd = 3
+	};
+}
+
+FCollisionTrajectoryWriter::FCollisionTrajectoryWriter()
+	: Writer(nullptr)
+{
+}
+
+FCollisionTrajectoryWriter::~FCollisionTrajectoryWriter()
+{
+	Close();
+}
+
+bool FCollisionTrajectoryWriter::Open(const FString& Filename)
+{
+	Close();
+
+	Writer = IFileManager::Get().CreateFileWriter(*Filename);
+	if (Writer == nullptr)
+	{
+		UE_LOG(LogCollisionTrajectoryCapture, Warning, TEXT("Couldn't open %s for writing"), *Filename);
+		return false;
+	}
+
+	uint32 Magic = CollisionTrajectoryFile::Magic;
+	uint32 Version = CollisionTrajectoryFile::Version;
+	*Writer << Magic;
+	*Writer << Version;
+
+	UE_LOG(LogCollisionTrajectoryCapture, Display, TEXT("Capturing collision trajectories to %s"), *Filename);
+	return true;
+}
+
+void FCollisionTrajectoryWriter::Close()
+{
+	if (Writer)
+	{
+		Writer->Close();
+		delete Writer;
+		Writer = nullptr;
+	}
+	WrittenTargets.Reset();
+}
+
+void FCollisionTrajectoryWriter::WriteActivationBegin(uint32 HandlerId, float TraceRadius, int32 NumSockets)
+{
+	if (Writer)
+	{
+		uint8 RecordType = CollisionTrajectoryFile::ActivationBegin;
+		*Writer << RecordType;
+		*Writer << HandlerId;
+		*Writer << TraceRadius;
+		*Writer << NumSockets;
+	}
+}
+
+void FCollisionTrajectoryWriter::WriteSampleBegin(uint32 HandlerId, float Time, const TArray<FVector>& SocketLocations, int32 NumTargets)
+{
+	if (Writer)
+	{
+		uint8 RecordType = CollisionTrajectoryFile::Sample;
+		int32 NumSockets = SocketLocations.Num();
+		*Writer << RecordType;
+		*Writer << HandlerId;
+		*Writer << Time;
+		*Writer << NumSockets;
+		for (FVector SocketLocation : SocketLocations)
+		{
+			*Writer << SocketLocation;
+		}
+		*Writer << NumTargets;
+	}
+}
+
+void FCollisionTrajectoryWriter::WriteTarget(uint32 TargetId, const FTransform& Transform, const FHurtboxCapsuleSet& Capsules, int32 FirstCapsule, int32 NumCapsules)
+{
+	if (Writer == nullptr)
+	{
+		return;
+	}
+
+	// bone names are written only with the first appearance of target in file, samples carry only capsule geometry
+	uint8 bHasBoneNames = WrittenTargets.Contains(TargetId) ? 0 : 1;
+	*Writer << TargetId;
+	*Writer << bHasBoneNames;
+	if (bHasBoneNames)
+	{
+		WrittenTargets.Add(TargetId);
+		int32 NumBoneNames = NumCapsules;
+		*Writer << NumBoneNames;
+		for (int32 CapsuleIndex = FirstCapsule; CapsuleIndex < FirstCapsule + NumCapsules; ++CapsuleIndex)
+		{
+			FString BoneName = Capsules.GetBoneName(CapsuleIndex).ToString();
+			*Writer << BoneName;
+		}
+	}
+
+	FTransform TargetTransform = Transform;
+	*Writer << TargetTransform;
+	*Writer << NumCapsules;
+	for (int32 CapsuleIndex = FirstCapsule; CapsuleIndex < FirstCapsule + NumCapsules; ++CapsuleIndex)
+	{
+		FVector Start = Capsules.GetStart(CapsuleIndex);
+		FVector End = Capsules.GetEnd(CapsuleIndex);
+		float Radius = Capsules.GetRadius(CapsuleIndex);
+		*Writer << Start;
+		*Writer << End;
+		*Writer << Radius;
+	}
+}
+
+void FCollisionTrajectoryWriter::WriteActivationEnd(uint32 HandlerId)
+{
+	if (Writer)
+	{
+		uint8 RecordType = CollisionTrajectoryFile::ActivationEnd;
+		*Writer << RecordType;
+		*Writer << HandlerId;
+	}
+}
+
+bool FCollisionTrajectoryWriter::LoadFromFile(const FString& Filename, FCapturedTrajectories& OutTrajectories)
+{
+	using namespace CollisionTrajectoryFile;
+
+	TUniquePtr<FArchive> Reader(IFileManager::Get().CreateFileReader(*Filename));
+	if (Reader.IsValid() == false)
+	{
+		return false;
+	}
+
+	uint32 FileMagic = 0;
+	uint32 FileVersion = 0;
+	*Reader << FileMagic;
+	*Reader << FileVersion;
+	if (FileMagic != Magic || FileVersion != Version)
+	{
+		UE_LOG(LogCollisionTrajectoryCapture, Warning, TEXT("%s is not a trajectory capture file"), *Filename);
+		return false;
+	}
+
+	// activations of interleaved handlers are built side by side until their end record
+	TMap<uint32, FCapturedActivation> OpenActivations;
+
+	while (Reader->AtEnd() == false && Reader->IsError() == false)
+	{
+		uint8 RecordType = 0;
+		uint32 Id = 0;
+		*Reader << RecordType;
+		*Reader << Id;
+
+		if (RecordType == ActivationBegin)
+		{
+			FCapturedActivation& Activation = OpenActivations.Add(Id);
+			Activation.HandlerId = Id;
+			*Reader << Activation.TraceRadius;
+			*Reader << Activation.NumSockets;
+		}
+		else if (RecordType == Sample)
+		{
+			// samples of handlers without open activation are read and dropped
+			FCapturedActivation Dropped;
+			FCapturedActivation* OpenActivation = OpenActivations.Find(Id);
+			FCapturedActivation& Activation = OpenActivation ? *OpenActivation : Dropped;
+
+			FCapturedSample CapturedSample;
+			int32 NumSockets = 0;
+			*Reader << CapturedSample.Time;
+			*Reader << NumSockets;
+			for (int32 Index = 0; Index < NumSockets && Reader->AtEnd() == false; ++Index)
+			{
+				FVector SocketLocation;
+				*Reader << SocketLocation;
+				Activation.SocketLocations.Add(SocketLocation);
+			}
+			Activation.NumSockets = NumSockets;
+
+			*Reader << CapturedSample.NumTargets;
+			CapturedSample.FirstTarget = Activation.Targets.Num();
+			for (int32 TargetIndex = 0; TargetIndex < CapturedSample.NumTargets && Reader->AtEnd() == false; ++TargetIndex)
+			{
+				FCapturedTarget CapturedTarget;
+				uint8 bHasBoneNames = 0;
+				*Reader << CapturedTarget.TargetId;
+				*Reader << bHasBoneNames;
+				if (bHasBoneNames)
+				{
+					int32 NumBoneNames = 0;
+					*Reader << NumBoneNames;
+					TArray<FName>& BoneNames = OutTrajectories.TargetBoneNames.FindOrAdd(CapturedTarget.TargetId);
+					BoneNames.Reset();
+					for (int32 Index = 0; Index < NumBoneNames && Reader->AtEnd() == false; ++Index)
+					{
+						FString BoneName;
+						*Reader << BoneName;
+						BoneNames.Add(FName(*BoneName));
+					}
+				}
+
+				*Reader << CapturedTarget.Transform;
+				*Reader << CapturedTarget.NumCapsules;
+				CapturedTarget.FirstCapsule = Activation.CapsuleStarts.Num();
+				for (int32 CapsuleIndex = 0; CapsuleIndex < CapturedTarget.NumCapsules && Reader->AtEnd() == false; ++CapsuleIndex)
+				{
+					FVector Start, End;
+					float Radius = 0.f;
+					*Reader << Start;
+					*Reader << End;
+					*Reader << Radius;
+					Activation.CapsuleStarts.Add(Start);
+					Activation.CapsuleEnds.Add(End);
+					Activation.CapsuleRadii.Add(Radius);
+				}
+				Activation.Targets.Add(CapturedTarget);
+			}
+
+			Activation.Samples.Add(CapturedSample);
+		}
+		else if (RecordType == ActivationEnd)
+		{
+			FCapturedActivation Activation;
+			if (OpenActivations.RemoveAndCopyValue(Id, Activation))
+			{
+				OutTrajectories.Activations.Add(MoveTemp(Activation));
+			}
+		}
+		else
+		{
+			UE_LOG(LogCollisionTrajectoryCapture, Warning, TEXT("Unknown record in %s, stopped reading"), *Filename);
+			break;
+		}
+	}
+
+	return true;
+}
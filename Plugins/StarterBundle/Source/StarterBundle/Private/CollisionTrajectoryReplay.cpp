@@ -0,0 +1,99 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "CollisionTrajectoryReplay.h"
+#include "CollisionHandlerComponent.h"
+#include "HurtboxCapsuleSet.h"
+#include "HAL/PlatformTime.h"
+
+void FCollisionTrajectoryReplay::Run(const FCapturedTrajectories& Trajectories, const FCollisionReplaySettings& Settings, FCollisionReplayResult& OutResult)
+{
+	const double StartTime = FPlatformTime::Seconds();
+	const int32 SampleStride = FMath::Max(Settings.SampleStride, 1);
+	const int32 ArcSubsteps = FMath::Max(Settings.ArcSubsteps, 1);
+
+	FHurtboxCapsuleSet Capsules;
+	TArray<FHurtboxCapsuleHit> CapsuleHits;
+	TSet<uint32> HitTargets;
+
+	for (int32 ActivationIndex = 0; ActivationIndex < Trajectories.Activations.Num(); ++ActivationIndex)
+	{
+		const FCapturedActivation& Activation = Trajectories.Activations[ActivationIndex];
+		const float TraceRadius = Settings.TraceRadius > 0.f ? Settings.TraceRadius : Activation.TraceRadius;
+		HitTargets.Reset();
+		++OutResult.NumActivations;
+
+		// like the live component, first used sample only stores socket locations
+		for (int32 SampleIndex = SampleStride; SampleIndex < Activation.Samples.Num(); SampleIndex += SampleStride)
+		{
+			const FCapturedSample& CapturedSample = Activation.Samples[SampleIndex];
+			const int32 LastSampleIndex = SampleIndex - SampleStride;
+			const int32 SecondLastSampleIndex = SampleIndex - 2 * SampleStride;
+			++OutResult.NumSamples;
+
+			// captured samples follow frames, so arcs are fitted to real times of samples like adaptive intervals of the live component
+			float ArcIntervalRatio = 1.f;
+			if (SecondLastSampleIndex >= 0)
+			{
+				const float LastInterval = Activation.Samples[LastSampleIndex].Time - Activation.Samples[SecondLastSampleIndex].Time;
+				const float Interval = CapturedSample.Time - Activation.Samples[LastSampleIndex].Time;
+				ArcIntervalRatio = LastInterval > KINDA_SMALL_NUMBER && Interval > KINDA_SMALL_NUMBER ? LastInterval / Interval : 1.f;
+			}
+
+			// hurtboxes are posed as they were at the current sample, owner index is index of target within the sample
+			Capsules.Reset();
+			for (int32 TargetIndex = 0; TargetIndex < CapturedSample.NumTargets; ++TargetIndex)
+			{
+				const FCapturedTarget& CapturedTarget = Activation.Targets[CapturedSample.FirstTarget + TargetIndex];
+				const TArray<FName>* BoneNames = Trajectories.TargetBoneNames.Find(CapturedTarget.TargetId);
+				for (int32 Index = 0; Index < CapturedTarget.NumCapsules; ++Index)
+				{
+					const int32 CapsuleIndex = CapturedTarget.FirstCapsule + Index;
+					const FName BoneName = BoneNames && BoneNames->IsValidIndex(Index) ? (*BoneNames)[Index] : NAME_None;
+					Capsules.Add(Activation.CapsuleStarts[CapsuleIndex], Activation.CapsuleEnds[CapsuleIndex], Activation.CapsuleRadii[CapsuleIndex], TargetIndex, BoneName);
+				}
+			}
+
+			for (int32 SocketIndex = 0; SocketIndex < Activation.NumSockets; ++SocketIndex)
+			{
+				const FVector& LastLocation = Activation.GetSocketLocation(LastSampleIndex, SocketIndex);
+				const FVector& CurrentLocation = Activation.GetSocketLocation(SampleIndex, SocketIndex);
+				const bool bUseArc = ArcSubsteps > 1 && SecondLastSampleIndex >= 0;
+
+				FVector StartTrace = LastLocation;
+				for (int32 Substep = 1; Substep <= ArcSubsteps; ++Substep)
+				{
+					const float Alpha = (float)Substep / (float)ArcSubsteps;
+					const FVector EndTrace = bUseArc && Substep < ArcSubsteps
+						? UCollisionHandlerComponent::InterpolateSocketArc(Activation.GetSocketLocation(SecondLastSampleIndex, SocketIndex), LastLocation, CurrentLocation, Alpha, ArcIntervalRatio)
+						: FMath::Lerp(LastLocation, CurrentLocation, Alpha);
+
+					CapsuleHits.Reset();
+					Capsules.SweepSphere(StartTrace, EndTrace, TraceRadius, CapsuleHits);
+					++OutResult.NumSweeps;
+
+					for (const FHurtboxCapsuleHit& CapsuleHit : CapsuleHits)
+					{
+						const FCapturedTarget& CapturedTarget = Activation.Targets[CapturedSample.FirstTarget + Capsules.GetOwnerIndex(CapsuleHit.CapsuleIndex)];
+						bool bWasAlreadyHit = false;
+						HitTargets.Add(CapturedTarget.TargetId, &bWasAlreadyHit);
+						if (bWasAlreadyHit == false)
+						{
+							FCollisionReplayHit ReplayHit;
+							ReplayHit.ActivationIndex = ActivationIndex;
+							ReplayHit.SampleIndex = SampleIndex;
+							ReplayHit.TargetId = CapturedTarget.TargetId;
+							ReplayHit.BoneName = Capsules.GetBoneName(CapsuleHit.CapsuleIndex);
+							ReplayHit.ImpactPoint = CapsuleHit.CapsuleLocation;
+							OutResult.Hits.Add(ReplayHit);
+						}
+					}
+
+					StartTrace = EndTrace;
+				}
+			}
+		}
+	}
+
+	OutResult.Seconds += FPlatformTime::Seconds() - StartTime;
+}
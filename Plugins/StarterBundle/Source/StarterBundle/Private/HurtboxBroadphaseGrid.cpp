@@ -0,0 +1,223 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "HurtboxBroadphaseGrid.h"
+
+namespace HurtboxBroadphaseGridImpl
+{
+	/* Queries overlapping more cells than this move to coarse level, e.g. very fast or very long sweeps */
+	static const int32 MaxQueryCells = 64;
+
+	/* Edge of coarse cell in fine cells, query of MaxQueryCells fine cells overlaps at most 8 coarse ones */
+	static const int32 CoarseCellFactor = 4;
+
+	/* Cell coordinates are wrapped to 21 bits, far apart cells may share a key and are separated by exact bounds test */
+	static const uint64 CellKeyMask = (1ull << 21) - 1;
+
+	/* Returns cell coordinate packed by MakeCellKey, exact for cells within 2^20 cells from origin */
+	FORCEINLINE int32 UnpackCellCoordinate(uint64 CellKey, int32 Shift)
+	{
+		return (int32)((uint32)((CellKey >> Shift) & CellKeyMask) << 11) >> 11;
+	}
+
+	/* Returns number of cells in range, zero if range is empty */
+	FORCEINLINE int64 CountCells(const FIntVector& MinCell, const FIntVector& MaxCell)
+	{
+		if (MinCell.X > MaxCell.X || MinCell.Y > MaxCell.Y || MinCell.Z > MaxCell.Z)
+		{
+			return 0;
+		}
+		return int64(MaxCell.X - MinCell.X + 1) * (MaxCell.Y - MinCell.Y + 1) * (MaxCell.Z - MinCell.Z + 1);
+	}
+
+	FORCEINLINE FIntVector ComponentMin(const FIntVector& A, const FIntVector& B)
+	{
+		return FIntVector(FMath::Min(A.X, B.X), FMath::Min(A.Y, B.Y), FMath::Min(A.Z, B.Z));
+	}
+
+	FORCEINLINE FIntVector ComponentMax(const FIntVector& A, const FIntVector& B)
+	{
+		return FIntVector(FMath::Max(A.X, B.X), FMath::Max(A.Y, B.Y), FMath::Max(A.Z, B.Z));
+	}
+}
+
+FHurtboxBroadphaseGrid::FHurtboxBroadphaseGrid()
+	: QueryStamp(0)
+{
+	FineLevel.CellSize = 200.f;
+	FineLevel.InvCellSize = 1.f / 200.f;
+	CoarseLevel.CellSize = FineLevel.CellSize * HurtboxBroadphaseGridImpl::CoarseCellFactor;
+	CoarseLevel.InvCellSize = 1.f / CoarseLevel.CellSize;
+}
+
+void FHurtboxBroadphaseGrid::Build(const TArray<FBox>& InOwnerBounds, float InCellSize)
+{
+	using namespace HurtboxBroadphaseGridImpl;
+
+	Reset();
+
+	OwnerBounds = InOwnerBounds;
+	OwnerQueryStamps.SetNumZeroed(OwnerBounds.Num());
+	QueryStamp = 0;
+
+	const float CellSize = FMath::Max(InCellSize, 1.f);
+	BuildLevel(FineLevel, CellSize);
+	BuildLevel(CoarseLevel, CellSize * CoarseCellFactor);
+}
+
+void FHurtboxBroadphaseGrid::BuildLevel(FLevel& Level, float InCellSize)
+{
+	using namespace HurtboxBroadphaseGridImpl;
+
+	Level.CellSize = InCellSize;
+	Level.InvCellSize = 1.f / InCellSize;
+	Level.MinCell = FIntVector(MAX_int32, MAX_int32, MAX_int32);
+	Level.MaxCell = FIntVector(MIN_int32, MIN_int32, MIN_int32);
+
+	for (int32 OwnerIndex = 0; OwnerIndex < OwnerBounds.Num(); ++OwnerIndex)
+	{
+		const FBox& Bounds = OwnerBounds[OwnerIndex];
+		if (Bounds.IsValid == false)
+		{
+			continue;
+		}
+
+		const FIntVector MinCell = Level.GetCell(Bounds.Min);
+		const FIntVector MaxCell = Level.GetCell(Bounds.Max);
+		Level.MinCell = ComponentMin(Level.MinCell, MinCell);
+		Level.MaxCell = ComponentMax(Level.MaxCell, MaxCell);
+		for (int32 X = MinCell.X; X <= MaxCell.X; ++X)
+		{
+			for (int32 Y = MinCell.Y; Y <= MaxCell.Y; ++Y)
+			{
+				for (int32 Z = MinCell.Z; Z <= MaxCell.Z; ++Z)
+				{
+					Level.Entries.Add({ MakeCellKey(X, Y, Z), OwnerIndex });
+				}
+			}
+		}
+	}
+
+	// entries of one cell become contiguous, so every cell is a single range
+	Level.Entries.Sort();
+	for (int32 Index = 0; Index < Level.Entries.Num(); ++Index)
+	{
+		FCellRange* Range = Level.Cells.Find(Level.Entries[Index].CellKey);
+		if (Range)
+		{
+			++Range->Num;
+		}
+		else
+		{
+			const uint64 CellKey = Level.Entries[Index].CellKey;
+			Level.Cells.Add(CellKey, { Index, 1, FIntVector(UnpackCellCoordinate(CellKey, 0), UnpackCellCoordinate(CellKey, 21), UnpackCellCoordinate(CellKey, 42)) });
+		}
+	}
+}
+
+void FHurtboxBroadphaseGrid::Reset()
+{
+	FineLevel.Entries.Reset();
+	FineLevel.Cells.Reset();
+	CoarseLevel.Entries.Reset();
+	CoarseLevel.Cells.Reset();
+	OwnerBounds.Reset();
+	OwnerQueryStamps.Reset();
+}
+
+void FHurtboxBroadphaseGrid::Query(const FBox& QueryBounds, TArray<int32>& OutOwnerIndices) const
+{
+	using namespace HurtboxBroadphaseGridImpl;
+
+	if (QueryBounds.IsValid == false || FineLevel.Entries.Num() == 0)
+	{
+		return;
+	}
+
+	// owners found in several cells are reported only by the first one, stamps are cleared when counter wraps
+	if (++QueryStamp == 0)
+	{
+		FMemory::Memzero(OwnerQueryStamps.GetData(), OwnerQueryStamps.Num() * sizeof(uint32));
+		QueryStamp = 1;
+	}
+
+	// cells outside of occupied range are empty, so query is clamped to it
+	const FIntVector FineMinCell = ComponentMax(FineLevel.GetCell(QueryBounds.Min), FineLevel.MinCell);
+	const FIntVector FineMaxCell = ComponentMin(FineLevel.GetCell(QueryBounds.Max), FineLevel.MaxCell);
+	if (CountCells(FineMinCell, FineMaxCell) <= MaxQueryCells)
+	{
+		QueryLevel(FineLevel, FineMinCell, FineMaxCell, QueryBounds, OutOwnerIndices);
+		return;
+	}
+
+	const FIntVector CoarseMinCell = ComponentMax(CoarseLevel.GetCell(QueryBounds.Min), CoarseLevel.MinCell);
+	const FIntVector CoarseMaxCell = ComponentMin(CoarseLevel.GetCell(QueryBounds.Max), CoarseLevel.MaxCell);
+	QueryLevel(CoarseLevel, CoarseMinCell, CoarseMaxCell, QueryBounds, OutOwnerIndices);
+}
+
+void FHurtboxBroadphaseGrid::QueryLevel(const FLevel& Level, const FIntVector& MinCell, const FIntVector& MaxCell, const FBox& QueryBounds, TArray<int32>& OutOwnerIndices) const
+{
+	using namespace HurtboxBroadphaseGridImpl;
+
+	const int64 NumQueryCells = CountCells(MinCell, MaxCell);
+	if (NumQueryCells == 0)
+	{
+		return;
+	}
+
+	// range is bigger than number of occupied cells, e.g. owners spread over large level, so occupied cells are tested instead
+	if (NumQueryCells > Level.Cells.Num())
+	{
+		for (const auto& Cell : Level.Cells)
+		{
+			const FIntVector& Coords = Cell.Value.Cell;
+			if (Coords.X >= MinCell.X && Coords.X <= MaxCell.X && Coords.Y >= MinCell.Y && Coords.Y <= MaxCell.Y && Coords.Z >= MinCell.Z && Coords.Z <= MaxCell.Z)
+			{
+				QueryCell(Level, Cell.Value, QueryBounds, OutOwnerIndices);
+			}
+		}
+		return;
+	}
+
+	for (int32 X = MinCell.X; X <= MaxCell.X; ++X)
+	{
+		for (int32 Y = MinCell.Y; Y <= MaxCell.Y; ++Y)
+		{
+			for (int32 Z = MinCell.Z; Z <= MaxCell.Z; ++Z)
+			{
+				if (const FCellRange* Range = Level.Cells.Find(MakeCellKey(X, Y, Z)))
+				{
+					QueryCell(Level, *Range, QueryBounds, OutOwnerIndices);
+				}
+			}
+		}
+	}
+}
+
+void FHurtboxBroadphaseGrid::QueryCell(const FLevel& Level, const FCellRange& Range, const FBox& QueryBounds, TArray<int32>& OutOwnerIndices) const
+{
+	for (int32 Index = Range.First; Index < Range.First + Range.Num; ++Index)
+	{
+		const int32 OwnerIndex = Level.Entries[Index].OwnerIndex;
+		if (OwnerQueryStamps[OwnerIndex] != QueryStamp)
+		{
+			OwnerQueryStamps[OwnerIndex] = QueryStamp;
+			if (OwnerBounds[OwnerIndex].Intersect(QueryBounds))
+			{
+				OutOwnerIndices.Add(OwnerIndex);
+			}
+		}
+	}
+}
+
+FIntVector FHurtboxBroadphaseGrid::FLevel::GetCell(const FVector& Location) const
+{
+	return FIntVector(FMath::FloorToInt(Location.X * InvCellSize), FMath::FloorToInt(Location.Y * InvCellSize), FMath::FloorToInt(Location.Z * InvCellSize));
+}
+
+uint64 FHurtboxBroadphaseGrid::MakeCellKey(int32 X, int32 Y, int32 Z)
+{
+	using namespace HurtboxBroadphaseGridImpl;
+
+	return ((uint64)X & CellKeyMask) | (((uint64)Y & CellKeyMask) << 21) | (((uint64)Z & CellKeyMask) << 42);
+}
@@ -0,0 +1,233 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "HurtboxCapsuleSet.h"
+
+namespace HurtboxCapsuleSetImpl
+{
+	/* Segments shorter than this are treated as points */
+	static const float DegenerateLengthSquared = KINDA_SMALL_NUMBER;
+
+	FORCEINLINE VectorRegister VectorClamp01(const VectorRegister& Value)
+	{
+		return VectorMin(VectorMax(Value, VectorZero()), VectorOne());
+	}
+
+	FORCEINLINE VectorRegister VectorDot3SoA(const VectorRegister& AX, const VectorRegister& AY, const VectorRegister& AZ,
+		const VectorRegister& BX, const VectorRegister& BY, const VectorRegister& BZ)
+	{
+		return VectorMultiplyAdd(AZ, BZ, VectorMultiplyAdd(AY, BY, VectorMultiply(AX, BX)));
+	}
+}
+
+void FHurtboxCapsuleSet::Reset()
+{
+	StartX.Reset();
+	StartY.Reset();
+	StartZ.Reset();
+	AxisX.Reset();
+	AxisY.Reset();
+	AxisZ.Reset();
+	Radii.Reset();
+	OwnerIndices.Reset();
+	BoneNames.Reset();
+	NumCapsules = 0;
+}
+
+int32 FHurtboxCapsuleSet::Add(const FVector& Start, const FVector& End, float Radius, int32 OwnerIndex, FName BoneName)
+{
+	const int32 Index = NumCapsules++;
+
+	// grow padded arrays by whole vectors so vector load from last capsule stays in bounds, padding lanes are skipped by SweepSphere
+	if (Index + 4 > StartX.Num())
+	{
+		StartX.AddZeroed(4);
+		StartY.AddZeroed(4);
+		StartZ.AddZeroed(4);
+		AxisX.AddZeroed(4);
+		AxisY.AddZeroed(4);
+		AxisZ.AddZeroed(4);
+		Radii.AddZeroed(4);
+	}
+
+	const FVector Axis = End - Start;
+	StartX[Index] = Start.X;
+	StartY[Index] = Start.Y;
+	StartZ[Index] = Start.Z;
+	AxisX[Index] = Axis.X;
+	AxisY[Index] = Axis.Y;
+	AxisZ[Index] = Axis.Z;
+	Radii[Index] = Radius;
+	OwnerIndices.Add(OwnerIndex);
+	BoneNames.Add(BoneName);
+
+	return Index;
+}
+
+FVector FHurtboxCapsuleSet::GetStart(int32 CapsuleIndex) const
+{
+	return FVector(StartX[CapsuleIndex], StartY[CapsuleIndex], StartZ[CapsuleIndex]);
+}
+
+FVector FHurtboxCapsuleSet::GetEnd(int32 CapsuleIndex) const
+{
+	return GetStart(CapsuleIndex) + FVector(AxisX[CapsuleIndex], AxisY[CapsuleIndex], AxisZ[CapsuleIndex]);
+}
+
+void FHurtboxCapsuleSet::SweepSphere(const FVector& Start, const FVector& End, float SphereRadius, TArray<FHurtboxCapsuleHit>& OutHits) const
+{
+	SweepSphere(Start, End, SphereRadius, 0, NumCapsules, OutHits);
+}
+
+void FHurtboxCapsuleSet::SweepSphere(const FVector& Start, const FVector& End, float SphereRadius, int32 FirstCapsule, int32 NumCapsulesToTest, TArray<FHurtboxCapsuleHit>& OutHits) const
+{
+	using namespace HurtboxCapsuleSetImpl;
+
+	// swept segment is the same for all lanes
+	const FVector SweepAxis = End - Start;
+	const float SweepLengthSquared = SweepAxis.SizeSquared();
+	const VectorRegister P1X = VectorSetFloat1(Start.X);
+	const VectorRegister P1Y = VectorSetFloat1(Start.Y);
+	const VectorRegister P1Z = VectorSetFloat1(Start.Z);
+	const VectorRegister D1X = VectorSetFloat1(SweepAxis.X);
+	const VectorRegister D1Y = VectorSetFloat1(SweepAxis.Y);
+	const VectorRegister D1Z = VectorSetFloat1(SweepAxis.Z);
+	const VectorRegister A = VectorSetFloat1(SweepLengthSquared);
+	const VectorRegister InvA = VectorSetFloat1(SweepLengthSquared > DegenerateLengthSquared ? 1.f / SweepLengthSquared : 0.f);
+	const VectorRegister SweepRadius = VectorSetFloat1(SphereRadius);
+	const VectorRegister Epsilon = VectorSetFloat1(DegenerateLengthSquared);
+
+	// ranges may start at any capsule, so loads are unaligned
+	const int32 EndCapsule = FMath::Min(FirstCapsule + NumCapsulesToTest, NumCapsules);
+	for (int32 Base = FirstCapsule; Base < EndCapsule; Base += 4)
+	{
+		const VectorRegister P2X = VectorLoad(&StartX[Base]);
+		const VectorRegister P2Y = VectorLoad(&StartY[Base]);
+		const VectorRegister P2Z = VectorLoad(&StartZ[Base]);
+		const VectorRegister D2X = VectorLoad(&AxisX[Base]);
+		const VectorRegister D2Y = VectorLoad(&AxisY[Base]);
+		const VectorRegister D2Z = VectorLoad(&AxisZ[Base]);
+		const VectorRegister RX = VectorSubtract(P1X, P2X);
+		const VectorRegister RY = VectorSubtract(P1Y, P2Y);
+		const VectorRegister RZ = VectorSubtract(P1Z, P2Z);
+
+		// closest points of two segments, see SegmentDistSquared for scalar version of the same branches
+		const VectorRegister E = VectorDot3SoA(D2X, D2Y, D2Z, D2X, D2Y, D2Z);
+		const VectorRegister F = VectorDot3SoA(D2X, D2Y, D2Z, RX, RY, RZ);
+		const VectorRegister C = VectorDot3SoA(D1X, D1Y, D1Z, RX, RY, RZ);
+		const VectorRegister B = VectorDot3SoA(D1X, D1Y, D1Z, D2X, D2Y, D2Z);
+		const VectorRegister Denom = VectorSubtract(VectorMultiply(A, E), VectorMultiply(B, B));
+
+		const VectorRegister NonParallel = VectorCompareGT(Denom, Epsilon);
+		const VectorRegister SafeDenom = VectorSelect(NonParallel, Denom, VectorOne());
+		VectorRegister S = VectorMultiply(VectorSubtract(VectorMultiply(B, F), VectorMultiply(C, E)), VectorReciprocalAccurate(SafeDenom));
+		S = VectorSelect(NonParallel, VectorClamp01(S), VectorZero());
+
+		const VectorRegister NonDegenerate = VectorCompareGT(E, Epsilon);
+		const VectorRegister SafeE = VectorSelect(NonDegenerate, E, VectorOne());
+		VectorRegister T = VectorMultiply(VectorMultiplyAdd(B, S, F), VectorReciprocalAccurate(SafeE));
+		T = VectorSelect(NonDegenerate, T, VectorZero());
+
+		// recompute S for lanes where closest point on capsule axis got clamped to its end
+		const VectorRegister BelowStart = VectorCompareLT(T, VectorZero());
+		const VectorRegister AboveEnd = VectorCompareGT(T, VectorOne());
+		const VectorRegister SAtStart = VectorClamp01(VectorMultiply(VectorNegate(C), InvA));
+		const VectorRegister SAtEnd = VectorClamp01(VectorMultiply(VectorSubtract(B, C), InvA));
+		S = VectorSelect(BelowStart, SAtStart, VectorSelect(AboveEnd, SAtEnd, S));
+		T = VectorClamp01(T);
+
+		// capsule which is a point (sphere), closest point on swept segment is projection of that point
+		S = VectorSelect(NonDegenerate, S, SAtStart);
+
+		// R + D1 * S - D2 * T
+		const VectorRegister DiffX = VectorSubtract(VectorMultiplyAdd(D1X, S, RX), VectorMultiply(D2X, T));
+		const VectorRegister DiffY = VectorSubtract(VectorMultiplyAdd(D1Y, S, RY), VectorMultiply(D2Y, T));
+		const VectorRegister DiffZ = VectorSubtract(VectorMultiplyAdd(D1Z, S, RZ), VectorMultiply(D2Z, T));
+		const VectorRegister DistSquared = VectorDot3SoA(DiffX, DiffY, DiffZ, DiffX, DiffY, DiffZ);
+
+		const VectorRegister RadiusSum = VectorAdd(SweepRadius, VectorLoad(&Radii[Base]));
+		const int32 HitMask = VectorMaskBits(VectorCompareLE(DistSquared, VectorMultiply(RadiusSum, RadiusSum)));
+
+		// hits are rare, so exact contact points are computed with scalar math only for lanes that passed
+		if (HitMask != 0)
+		{
+			for (int32 Lane = 0; Lane < 4; ++Lane)
+			{
+				const int32 CapsuleIndex = Base + Lane;
+				if ((HitMask & (1 << Lane)) && CapsuleIndex < EndCapsule)
+				{
+					FVector SweepLocation, CapsuleLocation;
+					SegmentDistSquared(Start, End, GetStart(CapsuleIndex), GetEnd(CapsuleIndex), SweepLocation, CapsuleLocation);
+					OutHits.Add(FHurtboxCapsuleHit(CapsuleIndex, SweepLocation, CapsuleLocation));
+				}
+			}
+		}
+	}
+}
+
+void FHurtboxCapsuleSet::SweepSphereScalar(const FVector& Start, const FVector& End, float SphereRadius, TArray<FHurtboxCapsuleHit>& OutHits) const
+{
+	for (int32 CapsuleIndex = 0; CapsuleIndex < NumCapsules; ++CapsuleIndex)
+	{
+		FVector SweepLocation, CapsuleLocation;
+		const float DistSquared = SegmentDistSquared(Start, End, GetStart(CapsuleIndex), GetEnd(CapsuleIndex), SweepLocation, CapsuleLocation);
+		if (DistSquared <= FMath::Square(SphereRadius + Radii[CapsuleIndex]))
+		{
+			OutHits.Add(FHurtboxCapsuleHit(CapsuleIndex, SweepLocation, CapsuleLocation));
+		}
+	}
+}
+
+SIZE_T FHurtboxCapsuleSet::GetAllocatedSize() const
+{
+	return StartX.GetAllocatedSize() + StartY.GetAllocatedSize() + StartZ.GetAllocatedSize()
+		+ AxisX.GetAllocatedSize() + AxisY.GetAllocatedSize() + AxisZ.GetAllocatedSize()
+		+ Radii.GetAllocatedSize() + OwnerIndices.GetAllocatedSize() + BoneNames.GetAllocatedSize();
+}
+
+float FHurtboxCapsuleSet::SegmentDistSquared(const FVector& P1, const FVector& Q1, const FVector& P2, const FVector& Q2, FVector& OutClosest1, FVector& OutClosest2)
+{
+	using namespace HurtboxCapsuleSetImpl;
+
+	const FVector D1 = Q1 - P1;
+	const FVector D2 = Q2 - P2;
+	const FVector R = P1 - P2;
+	const float A = D1 | D1;
+	const float E = D2 | D2;
+	const float F = D2 | R;
+	const float C = D1 | R;
+	const float B = D1 | D2;
+	const float Denom = A * E - B * B;
+	const float InvA = A > DegenerateLengthSquared ? 1.f / A : 0.f;
+
+	float S = 0.f;
+	float T = 0.f;
+
+	// second segment is a point, closest point on the first one is its projection
+	if (E <= DegenerateLengthSquared)
+	{
+		S = FMath::Clamp(-C * InvA, 0.f, 1.f);
+	}
+	else
+	{
+		// parameter on first segment of point closest to infinite line of second one, any point if lines are parallel
+		S = Denom > DegenerateLengthSquared ? FMath::Clamp((B * F - C * E) / Denom, 0.f, 1.f) : 0.f;
+		T = (B * S + F) / E;
+	}
+
+	// clamp to second segment and recompute closest point on the first one
+	if (T < 0.f)
+	{
+		T = 0.f;
+		S = FMath::Clamp(-C * InvA, 0.f, 1.f);
+	}
+	else if (T > 1.f)
+	{
+		T = 1.f;
+		S = FMath::Clamp((B - C) * InvA, 0.f, 1.f);
+	}
+
+	OutClosest1 = P1 + D1 * S;
+	OutClosest2 = P2 + D2 * T;
+	return (OutClosest1 - OutClosest2).SizeSquared();
+}
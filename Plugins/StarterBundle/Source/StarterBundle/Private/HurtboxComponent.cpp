@@ -0,0 +1,117 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "HurtboxComponent.h"
+#include "HurtboxCapsuleSet.h"
+#include "CollisionHandlerSubsystem.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "PhysicsEngine/PhysicsAsset.h"
+#include "PhysicsEngine/SkeletalBodySetup.h"
+#include "Engine/World.h"
+#include "GameFramework/Actor.h"
+
+// Sets default values for this component's properties
+UHurtboxComponent::UHurtboxComponent()
+	: HurtboxMesh(nullptr)
+{
+	PrimaryComponentTick.bCanEverTick = false;
+}
+
+// Called when the game starts
+void UHurtboxComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	if (HurtboxMesh == nullptr)
+	{
+		SetHurtboxMesh(GetOwner()->FindComponentByClass<USkeletalMeshComponent>());
+	}
+
+	if (UCollisionHandlerSubsystem* Subsystem = GetWorld()->GetSubsystem<UCollisionHandlerSubsystem>())
+	{
+		Subsystem->RegisterHurtbox(this);
+	}
+}
+
+// Called when the game ends
+void UHurtboxComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (UCollisionHandlerSubsystem* Subsystem = GetWorld()->GetSubsystem<UCollisionHandlerSubsystem>())
+	{
+		Subsystem->UnregisterHurtbox(this);
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void UHurtboxComponent::SetHurtboxMesh(USkeletalMeshComponent* NewHurtboxMesh)
+{
+	HurtboxMesh = NewHurtboxMesh;
+	BuildLocalCapsules();
+}
+
+USkeletalMeshComponent* UHurtboxComponent::GetHurtboxMesh() const
+{
+	return HurtboxMesh;
+}
+
+void UHurtboxComponent::BuildLocalCapsules()
+{
+	LocalCapsules.Reset();
+
+	UPhysicsAsset* PhysicsAsset = HurtboxMesh ? HurtboxMesh->GetPhysicsAsset() : nullptr;
+	if (PhysicsAsset == nullptr)
+	{
+		return;
+	}
+
+	for (const USkeletalBodySetup* BodySetup : PhysicsAsset->SkeletalBodySetups)
+	{
+		if (BodySetup == nullptr || IgnoredBones.Contains(BodySetup->BoneName))
+		{
+			continue;
+		}
+
+		const int32 BoneIndex = HurtboxMesh->GetBoneIndex(BodySetup->BoneName);
+		if (BoneIndex == INDEX_NONE)
+		{
+			continue;
+		}
+
+		// sphyl axis is Z of its element transform
+		for (const FKSphylElem& SphylElem : BodySetup->AggGeom.SphylElems)
+		{
+			const FTransform ElemTransform = SphylElem.GetTransform();
+			const FVector HalfAxis(0.f, 0.f, 0.5f * SphylElem.Length);
+			LocalCapsules.Add({ BoneIndex, BodySetup->BoneName, ElemTransform.TransformPosition(HalfAxis), ElemTransform.TransformPosition(-HalfAxis), SphylElem.Radius });
+		}
+		for (const FKSphereElem& SphereElem : BodySetup->AggGeom.SphereElems)
+		{
+			LocalCapsules.Add({ BoneIndex, BodySetup->BoneName, SphereElem.Center, SphereElem.Center, SphereElem.Radius });
+		}
+	}
+}
+
+void UHurtboxComponent::AppendWorldCapsules(FHurtboxCapsuleSet& Capsules, int32 OwnerIndex) const
+{
+	if (HurtboxMesh == nullptr || HurtboxMesh->IsRegistered() == false)
+	{
+		return;
+	}
+
+	const TArray<FTransform>& ComponentSpaceTransforms = HurtboxMesh->GetComponentSpaceTransforms();
+	const FTransform& ComponentTransform = HurtboxMesh->GetComponentTransform();
+
+	for (const FLocalCapsule& LocalCapsule : LocalCapsules)
+	{
+		if (ComponentSpaceTransforms.IsValidIndex(LocalCapsule.BoneIndex) == false)
+		{
+			continue;
+		}
+
+		// physics bodies ignore non uniform scale the same way, largest axis scales the radius
+		const FTransform BoneTransform = ComponentSpaceTransforms[LocalCapsule.BoneIndex] * ComponentTransform;
+		Capsules.Add(BoneTransform.TransformPosition(LocalCapsule.Start), BoneTransform.TransformPosition(LocalCapsule.End),
+			LocalCapsule.Radius * BoneTransform.GetMaximumAxisScale(), OwnerIndex, LocalCapsule.BoneName);
+	}
+}
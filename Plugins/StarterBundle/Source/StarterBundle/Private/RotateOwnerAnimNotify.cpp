@@ -4,6 +4,7 @@
 #include "RotateOwnerAnimNotify.h"
 #include "RotatingComponent.h"
 #include "Components/SkeletalMeshComponent.h"
+#include "StarterBundleStats.h"
 
 URotateOwnerAnimNotify::URotateOwnerAnimNotify()
 	: DegreesPerSecond(540.f), MaxPossibleRotation(180.f)
@@ -13,13 +14,15 @@ URotateOwnerAnimNotify::URotateOwnerAnimNotify()
 
 void URotateOwnerAnimNotify::Notify(USkeletalMeshComponent* MeshComp, UAnimSequenceBase* Animation)
 {
+	STARTERBUNDLE_SCOPE_CYCLE_COUNTER(STAT_AnimNotifyDispatch);
+
 	if (MeshComp)
 	{
 		AActor* Owner = MeshComp->GetOwner();
 
 		if (Owner)
 		{
-			URotatingComponent* RotatingComponent = Cast<URotatingComponent>(Owner->GetComponentByClass(URotatingComponent::StaticClass()));
+			URotatingComponent* RotatingComponent = URotatingComponent::FindRotatingComponent(Owner);
 
 			if (RotatingComponent)
 			{
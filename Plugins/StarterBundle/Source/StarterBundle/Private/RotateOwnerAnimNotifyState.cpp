@@ -4,6 +4,7 @@
 #include "RotateOwnerAnimNotifyState.h"
 #include "RotatingComponent.h"
 #include "Components/SkeletalMeshComponent.h"
+#include "StarterBundleStats.h"
 
 URotateOwnerAnimNotifyState::URotateOwnerAnimNotifyState()
 	: DegreesPerSecond(540.f)
@@ -13,13 +14,15 @@ URotateOwnerAnimNotifyState::URotateOwnerAnimNotifyState()
 
 void URotateOwnerAnimNotifyState::NotifyBegin(USkeletalMeshComponent * MeshComp, UAnimSequenceBase * Animation, float TotalDuration)
 {
+	STARTERBUNDLE_SCOPE_CYCLE_COUNTER(STAT_AnimNotifyDispatch);
+
 	if (MeshComp)
 	{
 		AActor* Owner = MeshComp->GetOwner();
 
 		if (Owner)
 		{
-			URotatingComponent* RotatingComponent = Cast<URotatingComponent>(Owner->GetComponentByClass(URotatingComponent::StaticClass()));
+			URotatingComponent* RotatingComponent = URotatingComponent::FindRotatingComponent(Owner);
 
 			if (RotatingComponent)
 			{
@@ -31,13 +34,15 @@ void URotateOwnerAnimNotifyState::NotifyBegin(USkeletalMeshComponent * MeshComp,
 
 void URotateOwnerAnimNotifyState::NotifyEnd(USkeletalMeshComponent * MeshComp, UAnimSequenceBase * Animation)
 {
+	STARTERBUNDLE_SCOPE_CYCLE_COUNTER(STAT_AnimNotifyDispatch);
+
 	if (MeshComp)
 	{
 		AActor* Owner = MeshComp->GetOwner();
 
 		if (Owner)
 		{
-			URotatingComponent* RotatingComponent = Cast<URotatingComponent>(Owner->GetComponentByClass(URotatingComponent::StaticClass()));
+			URotatingComponent* RotatingComponent = URotatingComponent::FindRotatingComponent(Owner);
 
 			if (RotatingComponent)
 			{
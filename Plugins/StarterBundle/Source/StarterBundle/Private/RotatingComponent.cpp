@@ -3,15 +3,26 @@
 
 #include "RotatingComponent.h"
 #include "RotatingComponentInterface.h"
+#include "RotatingComponentSubsystem.h"
+#include "StarterBundleStats.h"
+#include "Engine/World.h"
 #include "Kismet/KismetMathLibrary.h"
+#include "GameFramework/Actor.h"
+#include "UObject/ObjectKey.h"
+
+namespace RotatingComponentLookup
+{
+	/* Registered rotating components keyed by owner, used by anim notifies to avoid scanning owner components */
+	static TMap<FObjectKey, TWeakObjectPtr<URotatingComponent>> ComponentsByOwner;
+}
 
 // Sets default values for this component's properties
 URotatingComponent::URotatingComponent()
-	: DegreesPerSecond(540.f), bIsRotating(false)
+	: bUseBatchedRotation(false), DegreesPerSecond(540.f), bIsRotating(false)
 {
-	// Set this component to be initialized when the game starts, and to be ticked every frame.  You can turn these features
-	// off to improve performance if you don't need them.
+	// Component ticks only while rotating, tick is enabled in StartRotating and disabled in StopRotating
 	PrimaryComponentTick.bCanEverTick = true;
+	PrimaryComponentTick.bStartWithTickEnabled = false;
 
 	// ...
 }
@@ -21,8 +32,68 @@ void URotatingComponent::BeginPlay()
 {
 	Super::BeginPlay();
 
-	// ...
-	
+	// interface implementation doesn't change during play, so check it only once
+	AActor* Owner = GetOwner();
+	bOwnerImplementsInterface = Owner && Owner->GetClass()->ImplementsInterface(URotatingComponentInterface::StaticClass());
+}
+
+void URotatingComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (bIsRotating)
+	{
+		DEC_DWORD_STAT(STAT_RotatingActors);
+		bIsRotating = false;
+	}
+	StopUpdatingRotation();
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void URotatingComponent::OnRegister()
+{
+	Super::OnRegister();
+
+	// first registered component is used, same as GetComponentByClass
+	if (AActor* Owner = GetOwner())
+	{
+		TWeakObjectPtr<URotatingComponent>& Component = RotatingComponentLookup::ComponentsByOwner.FindOrAdd(FObjectKey(Owner));
+		if (Component.IsValid() == false)
+		{
+			Component = this;
+		}
+	}
+}
+
+void URotatingComponent::OnUnregister()
+{
+	if (AActor* Owner = GetOwner())
+	{
+		const FObjectKey OwnerKey(Owner);
+		const TWeakObjectPtr<URotatingComponent>* Component = RotatingComponentLookup::ComponentsByOwner.Find(OwnerKey);
+		if (Component && (Component->IsValid() == false || Component->Get() == this))
+		{
+			RotatingComponentLookup::ComponentsByOwner.Remove(OwnerKey);
+
+			// owner may have another rotating component which should be used from now on
+			TInlineComponentArray<URotatingComponent*> OwnerComponents(Owner);
+			for (URotatingComponent* OwnerComponent : OwnerComponents)
+			{
+				if (OwnerComponent != this && OwnerComponent->IsRegistered())
+				{
+					RotatingComponentLookup::ComponentsByOwner.Add(OwnerKey, OwnerComponent);
+					break;
+				}
+			}
+		}
+	}
+
+	Super::OnUnregister();
+}
+
+URotatingComponent* URotatingComponent::FindRotatingComponent(const AActor* Actor)
+{
+	const TWeakObjectPtr<URotatingComponent>* Component = RotatingComponentLookup::ComponentsByOwner.Find(FObjectKey(Actor));
+	return Component ? Component->Get() : nullptr;
 }
 
 void URotatingComponent::NotifyOnRotatingStart()
@@ -42,34 +113,30 @@ void URotatingComponent::TickComponent(float DeltaTime, ELevelTick TickType, FAc
 {
 	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
 
+	UpdateRotation(DeltaTime);
+}
+
+void URotatingComponent::UpdateRotation(float DeltaTime)
+{
+	STARTERBUNDLE_SCOPE_CYCLE_COUNTER(STAT_UpdateRotation);
+
 	if (bIsRotating)
 	{
 		TimeElapsed += DeltaTime;
 		// check if elapsed time doesn't exceed RotatingTime
 		if (TimeElapsed <= RotatingTime)
 		{
-			// make sure owner implements interface IRotatingComponent and then retrieve desired rotation 
 			AActor* Owner = GetOwner();
-			if (Owner)
+			FRotator DesiredRotation;
+			if (Owner && GetDesiredRotation(Owner, DesiredRotation))
 			{
-				// Blueprints Interface check version
-				if (Owner->GetClass()->ImplementsInterface(URotatingComponentInterface::StaticClass()))
+				FRotator CurrentRotation = Owner->GetActorRotation();
+				FRotator NewRotation = UKismetMathLibrary::RInterpTo_Constant(CurrentRotation, DesiredRotation, DeltaTime, DegreesPerSecond);
+				// skip moving owner once desired rotation is reached
+				if (NewRotation.Equals(CurrentRotation) == false)
 				{
-					FRotator DesiredRotation = IRotatingComponentInterface::Execute_GetDesiredRotation(Owner);
-					FRotator CurrentRotation = Owner->GetActorRotation();
-					FRotator NewRotation = UKismetMathLibrary::RInterpTo_Constant(CurrentRotation, DesiredRotation, DeltaTime, DegreesPerSecond);
 					Owner->SetActorRotation(NewRotation);
 				}
-
-				 // C++ Interface check version
-				/*IRotatingComponentInterface* RCI = Cast<IRotatingComponentInterface>(Owner);
-				if (RCI)
-				{
-					FRotator DesiredRotation = RCI->Execute_GetDesiredRotation(Owner);
-					FRotator CurrentRotation = Owner->GetActorRotation();
-					FRotator NewRotation = UKismetMathLibrary::RInterpTo_Constant(CurrentRotation, DesiredRotation, DeltaTime, DegreesPerSecond);
-					Owner->SetActorRotation(NewRotation);
-				}*/
 			}
 		}
 		else
@@ -79,6 +146,38 @@ void URotatingComponent::TickComponent(float DeltaTime, ELevelTick TickType, FAc
 	}
 }
 
+bool URotatingComponent::GetDesiredRotation(AActor* Owner, FRotator& OutDesiredRotation) const
+{
+	// pushed rotation first, then native provider, Blueprint interface call is the slowest path
+	if (bHasPushedDesiredRotation)
+	{
+		OutDesiredRotation = PushedDesiredRotation;
+		return true;
+	}
+	if (DesiredRotationProvider.IsBound())
+	{
+		OutDesiredRotation = DesiredRotationProvider.Execute();
+		return true;
+	}
+	if (bOwnerImplementsInterface)
+	{
+		OutDesiredRotation = IRotatingComponentInterface::Execute_GetDesiredRotation(Owner);
+		return true;
+	}
+	return false;
+}
+
+void URotatingComponent::SetDesiredRotation(FRotator Rotation)
+{
+	PushedDesiredRotation = Rotation;
+	bHasPushedDesiredRotation = true;
+}
+
+void URotatingComponent::ClearDesiredRotation()
+{
+	bHasPushedDesiredRotation = false;
+}
+
 bool URotatingComponent::IsRotating() const
 {
 	return bIsRotating;
@@ -89,7 +188,12 @@ void URotatingComponent::StartRotating(float time, float degressPerSecond)
 	RotatingTime = time;
 	DegreesPerSecond = degressPerSecond;
 	TimeElapsed = 0.f;
+	if (bIsRotating == false)
+	{
+		INC_DWORD_STAT(STAT_RotatingActors);
+	}
 	bIsRotating = true;
+	StartUpdatingRotation();
 	NotifyOnRotatingStart();
 }
 
@@ -102,6 +206,46 @@ void URotatingComponent::StartRotatingWithLimit(float maxPossibleRotation, float
 
 void URotatingComponent::StopRotating()
 {
+	if (bIsRotating)
+	{
+		DEC_DWORD_STAT(STAT_RotatingActors);
+	}
 	bIsRotating = false;
+	StopUpdatingRotation();
 	NotifyOnRotatingEnd();
 }
+
+void URotatingComponent::StartUpdatingRotation()
+{
+	// rotating restarted while already rotating, keep current mode unless it was changed
+	if (bIsRegisteredInSubsystem == bUseBatchedRotation && (bIsRegisteredInSubsystem || IsComponentTickEnabled()))
+	{
+		return;
+	}
+	StopUpdatingRotation();
+
+	URotatingComponentSubsystem* Subsystem = bUseBatchedRotation && GetWorld() ? GetWorld()->GetSubsystem<URotatingComponentSubsystem>() : nullptr;
+	if (Subsystem)
+	{
+		bIsRegisteredInSubsystem = true;
+		Subsystem->RegisterComponent(this);
+	}
+	else
+	{
+		SetComponentTickEnabled(true);
+	}
+}
+
+void URotatingComponent::StopUpdatingRotation()
+{
+	if (bIsRegisteredInSubsystem)
+	{
+		bIsRegisteredInSubsystem = false;
+		if (URotatingComponentSubsystem* Subsystem = GetWorld() ? GetWorld()->GetSubsystem<URotatingComponentSubsystem>() : nullptr)
+		{
+			Subsystem->UnregisterComponent(this);
+		}
+	}
+
+	SetComponentTickEnabled(false);
+}
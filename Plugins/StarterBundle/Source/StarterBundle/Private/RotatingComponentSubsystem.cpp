@@ -0,0 +1,82 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "RotatingComponentSubsystem.h"
+#include "RotatingComponent.h"
+
+void URotatingComponentSubsystem::Deinitialize()
+{
+	RotatingComponents.Empty();
+
+	Super::Deinitialize();
+}
+
+void URotatingComponentSubsystem::Tick(float DeltaTime)
+{
+	bIsProcessingComponents = true;
+
+	// components registered during the pass are appended and processed in the same pass
+	for (int32 Index = 0; Index < RotatingComponents.Num(); ++Index)
+	{
+		URotatingComponent* Component = RotatingComponents[Index];
+		if (Component)
+		{
+			Component->UpdateRotation(DeltaTime);
+		}
+	}
+
+	bIsProcessingComponents = false;
+
+	// compact slots of components unregistered during the pass
+	if (bHasPendingRemovals)
+	{
+		RotatingComponents.Remove(nullptr);
+		bHasPendingRemovals = false;
+	}
+}
+
+bool URotatingComponentSubsystem::IsTickable() const
+{
+	return RotatingComponents.Num() > 0;
+}
+
+TStatId URotatingComponentSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(URotatingComponentSubsystem, STATGROUP_Tickables);
+}
+
+UWorld* URotatingComponentSubsystem::GetTickableGameObjectWorld() const
+{
+	return GetWorld();
+}
+
+void URotatingComponentSubsystem::RegisterComponent(URotatingComponent* Component)
+{
+	if (Component && RotatingComponents.Contains(Component) == false)
+	{
+		RotatingComponents.Add(Component);
+	}
+}
+
+void URotatingComponentSubsystem::UnregisterComponent(URotatingComponent* Component)
+{
+	const int32 Index = RotatingComponents.Find(Component);
+	if (Component && Index != INDEX_NONE)
+	{
+		// while the pass is running only clear the slot so indices of remaining components stay valid
+		if (bIsProcessingComponents)
+		{
+			RotatingComponents[Index] = nullptr;
+			bHasPendingRemovals = true;
+		}
+		else
+		{
+			RotatingComponents.RemoveAt(Index);
+		}
+	}
+}
+
+int32 URotatingComponentSubsystem::GetNumRotatingComponents() const
+{
+	return RotatingComponents.Num();
+}
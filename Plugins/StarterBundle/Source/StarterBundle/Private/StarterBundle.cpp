@@ -1,6 +1,34 @@
 // Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
 
 #include "StarterBundle.h"
+#include "StarterBundleStats.h"
+
+CSV_DEFINE_CATEGORY(StarterBundle, true);
+
+#if !UE_BUILD_SHIPPING
+thread_local bool FStarterBundleAllocationScope::bIsTracking = false;
+#endif
+
+DEFINE_STAT(STAT_TimerTraceCheck);
+DEFINE_STAT(STAT_PoseTraceCheck);
+DEFINE_STAT(STAT_BatchedTraceCheck);
+DEFINE_STAT(STAT_ParallelSweeps);
+DEFINE_STAT(STAT_UpdateSocketLocations);
+DEFINE_STAT(STAT_PerformTraceCheck);
+DEFINE_STAT(STAT_UpdateHurtboxes);
+DEFINE_STAT(STAT_AsyncTraceResults);
+DEFINE_STAT(STAT_NotifyOnHit);
+DEFINE_STAT(STAT_UpdateRotation);
+DEFINE_STAT(STAT_AnimNotifyDispatch);
+DEFINE_STAT(STAT_ActiveCollisionHandlers);
+DEFINE_STAT(STAT_RotatingActors);
+DEFINE_STAT(STAT_SweepsIssued);
+DEFINE_STAT(STAT_HitResultsReturned);
+DEFINE_STAT(STAT_HitsFiltered);
+DEFINE_STAT(STAT_HitsDelivered);
+DEFINE_STAT(STAT_TraceChecksCulled);
+DEFINE_STAT(STAT_MidpointOverlaps);
+DEFINE_STAT(STAT_HitHistoryMemory);
 
 #define LOCTEXT_NAMESPACE "FStarterBundleModule"
 
@@ -0,0 +1,679 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "StarterBundleBenchmarkCommandlet.h"
+#include "ActivateCollisionNotifyState.h"
+#include "CollisionHandlerComponent.h"
+#include "CollisionHandlerSubsystem.h"
+#include "HurtboxComponent.h"
+#include "RotatingComponent.h"
+#include "StarterBundleStats.h"
+#include "Animation/AnimInstance.h"
+#include "Animation/AnimMontage.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Engine/Engine.h"
+#include "Engine/SkeletalMesh.h"
+#include "Engine/World.h"
+#include "GameFramework/Actor.h"
+#include "HAL/PlatformTime.h"
+#include "HAL/MemoryBase.h"
+#include "HAL/ThreadSafeCounter64.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogStarterBundleBenchmark, Log, All);
+
+namespace StarterBundleBenchmark
+{
+	/* Part of the montage in which collision is activated if montage has no ActivateCollisionNotifyState */
+	const float SyntheticWindowStart = 0.3f;
+	const float SyntheticWindowEnd = 0.6f;
+
+	/* Distance between actors, small enough for neighbours to be hit */
+	const float ActorSpacing = 120.f;
+
+	/* Creates game world with physics scene, ticked manually */
+	UWorld* CreateBenchmarkWorld()
+	{
+		UWorld* World = UWorld::CreateWorld(EWorldType::Game, false, TEXT("StarterBundleBenchmark"));
+		FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+		WorldContext.SetCurrentWorld(World);
+		World->InitializeActorsForPlay(FURL());
+		World->BeginPlay();
+		return World;
+	}
+
+	/* Destroys world created by CreateBenchmarkWorld together with its actors */
+	void DestroyBenchmarkWorld(UWorld* World)
+	{
+		GEngine->DestroyWorldContext(World);
+		World->DestroyWorld(false);
+		CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+	}
+
+	/* Logs result of microbenchmark variant and appends it to CSV */
+	void AddMicroResult(FString& Csv, const TCHAR* Benchmark, const TCHAR* Variant, int32 NumIterations, double Seconds)
+	{
+		const FString Line = FString::Printf(TEXT("%s,%s,%d,%.2f"), Benchmark, Variant, NumIterations, NumIterations > 0 ? Seconds * 1e9 / NumIterations : 0.0);
+		UE_LOG(LogStarterBundleBenchmark, Display, TEXT("%s"), *Line);
+		Csv += Line + TEXT("\n");
+	}
+
+	/* Returns key of hit of victim by attacker during its given activation, all indices are below 2^20 */
+	uint64 MakeHitKey(int32 AttackerIndex, int32 Activation, int32 VictimIndex)
+	{
+		return ((uint64)AttackerIndex << 40) | ((uint64)(Activation & 0xFFFFF) << 20) | (uint64)VictimIndex;
+	}
+
+	/* Actor of single benchmark run */
+	struct FBenchmarkActor
+	{
+		AActor* Actor;
+		USkeletalMeshComponent* Mesh;
+		UCollisionHandlerComponent* CollisionHandler;
+		URotatingComponent* RotatingComponent;
+	};
+
+#if !UE_BUILD_SHIPPING
+	/**
+	 * Pass-through allocator which counts allocations of any thread inside FStarterBundleAllocationScope, e.g. sweeps on trace workers.
+	 * Installed over GMalloc only for measured frames, every call is forwarded so blocks can be freed by either allocator.
+	 */
+	class FCountingMalloc : public FMalloc
+	{
+	public:
+		FMalloc* Inner = nullptr;
+		FThreadSafeCounter64 NumAllocations;
+
+		virtual void* Malloc(SIZE_T Count, uint32 Alignment) override
+		{
+			CountAllocation();
+			return Inner->Malloc(Count, Alignment);
+		}
+
+		virtual void* Realloc(void* Original, SIZE_T Count, uint32 Alignment) override
+		{
+			if (Count > 0)
+			{
+				CountAllocation();
+			}
+			return Inner->Realloc(Original, Count, Alignment);
+		}
+
+		virtual void Free(void* Original) override
+		{
+			Inner->Free(Original);
+		}
+
+		virtual SIZE_T QuantizeSize(SIZE_T Count, uint32 Alignment) override
+		{
+			return Inner->QuantizeSize(Count, Alignment);
+		}
+
+		virtual bool GetAllocationSize(void* Original, SIZE_T& SizeOut) override
+		{
+			return Inner->GetAllocationSize(Original, SizeOut);
+		}
+
+		virtual bool IsInternallyThreadSafe() const override
+		{
+			return Inner->IsInternallyThreadSafe();
+		}
+
+		virtual const TCHAR* GetDescriptiveName() override
+		{
+			return TEXT("StarterBundleCountingMalloc");
+		}
+
+	private:
+		void CountAllocation()
+		{
+			if (FStarterBundleAllocationScope::bIsTracking)
+			{
+				NumAllocations.Increment();
+			}
+		}
+	};
+
+	/* Kept alive for the whole process, other threads may still be inside it after GMalloc is restored */
+	static FCountingMalloc CountingMalloc;
+#endif
+}
+
+UStarterBundleBenchmarkCommandlet::UStarterBundleBenchmarkCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = false;
+	LogToConsole = true;
+}
+
+int32 UStarterBundleBenchmarkCommandlet::Main(const FString& Params)
+{
+	FString CountsValue = TEXT("25,50,100,200");
+	FParse::Value(*Params, TEXT("Counts="), CountsValue);
+	FString MeshPath = TEXT("/Game/Mannequin/Character/Mesh/SK_Mannequin.SK_Mannequin");
+	FParse::Value(*Params, TEXT("Mesh="), MeshPath);
+	FString MontagePath = TEXT("/Game/1HS_Attack_02_Montage.1HS_Attack_02_Montage");
+	FParse::Value(*Params, TEXT("Montage="), MontagePath);
+	FString SocketsValue = TEXT("hand_r,lowerarm_r");
+	FParse::Value(*Params, TEXT("Sockets="), SocketsValue);
+	FString TraceWorkersValue = TEXT("0");
+	FParse::Value(*Params, TEXT("TraceWorkers="), TraceWorkersValue);
+	FString OutputPath = FPaths::ProjectSavedDir() / TEXT("Benchmarks/StarterBundleBenchmark.csv");
+	FParse::Value(*Params, TEXT("Output="), OutputPath);
+
+	USkeletalMesh* Mesh = LoadObject<USkeletalMesh>(nullptr, *MeshPath);
+	UAnimMontage* Montage = LoadObject<UAnimMontage>(nullptr, *MontagePath);
+	if (Mesh == nullptr || Montage == nullptr)
+	{
+		UE_LOG(LogStarterBundleBenchmark, Error, TEXT("Couldn't load mesh %s or montage %s"), *MeshPath, *MontagePath);
+		return 1;
+	}
+
+	TArray<FString> SocketStrings;
+	SocketsValue.ParseIntoArray(SocketStrings, TEXT(","));
+	TArray<FName> Sockets;
+	for (const FString& SocketString : SocketStrings)
+	{
+		Sockets.Add(FName(*SocketString));
+	}
+
+	// microbenchmarks replace scene runs
+	FString MicroValue;
+	if (FParse::Value(*Params, TEXT("Micro="), MicroValue))
+	{
+		return RunMicrobenchmarks(MicroValue, Params, Mesh, Montage, Sockets);
+	}
+
+	TArray<FString> CountStrings;
+	CountsValue.ParseIntoArray(CountStrings, TEXT(","));
+
+	TArray<FString> TraceWorkersStrings;
+	TraceWorkersValue.ParseIntoArray(TraceWorkersStrings, TEXT(","));
+
+	const bool bCheckAllocations = FParse::Param(*Params, TEXT("CheckAllocations"));
+	bool bHasTraceLoopAllocations = false;
+
+	// timers and subsystem are compared on the same counts, so the CSV has both modes next to each other
+	TArray<bool> BatchingModes;
+	if (FParse::Param(*Params, TEXT("CompareBatching")))
+	{
+		BatchingModes.Add(false);
+		BatchingModes.Add(true);
+	}
+	else
+	{
+		BatchingModes.Add(FParse::Param(*Params, TEXT("NoBatching")) == false);
+	}
+
+	// intervals are compared by hits missing from reference run, without them every run uses default interval
+	FString IntervalsValue;
+	FParse::Value(*Params, TEXT("Intervals="), IntervalsValue);
+	TArray<FString> IntervalStrings;
+	IntervalsValue.ParseIntoArray(IntervalStrings, TEXT(","));
+	TArray<float> Intervals;
+	for (const FString& IntervalString : IntervalStrings)
+	{
+		Intervals.Add(FMath::Max(FCString::Atof(*IntervalString), 0.f));
+	}
+	const bool bCountMissedHits = Intervals.Num() > 0;
+	if (bCountMissedHits == false)
+	{
+		Intervals.Add(0.f);
+	}
+	float ReferenceInterval = 1.f / 120.f;
+	FParse::Value(*Params, TEXT("ReferenceInterval="), ReferenceInterval);
+
+	FString Csv = TEXT("Actors,Batching,TraceWorkers,TraceInterval,Frames,GameThreadMsPerFrame,SweepsPerSecond,Sweeps,Hits,MissedHits,TraceLoopAllocations\n");
+	for (const FString& CountString : CountStrings)
+	{
+		FStarterBundleBenchmarkSettings Settings;
+		Settings.NumActors = FCString::Atoi(*CountString);
+		Settings.NumTraceWorkers = 0;
+		Settings.bUseBatching = true;
+		Settings.TraceCheckInterval = 0.f;
+		Settings.bIsReference = false;
+		if (Settings.NumActors <= 0)
+		{
+			continue;
+		}
+
+		TSet<uint64> ReferenceHitKeys;
+		if (bCountMissedHits)
+		{
+			FStarterBundleBenchmarkSettings ReferenceSettings = Settings;
+			ReferenceSettings.NumTraceWorkers = 0;
+			ReferenceSettings.bUseBatching = BatchingModes[0];
+			ReferenceSettings.TraceCheckInterval = ReferenceInterval;
+			ReferenceSettings.bIsReference = true;
+			ReferenceHitKeys = MoveTemp(RunBenchmark(ReferenceSettings, Params, Mesh, Montage, Sockets).HitKeys);
+		}
+
+		// every combination of varied options is run in new world with the same count
+		TArray<FStarterBundleBenchmarkSettings> Runs;
+		for (const bool bUseBatching : BatchingModes)
+		{
+			Settings.bUseBatching = bUseBatching;
+			for (const FString& TraceWorkersString : TraceWorkersStrings)
+			{
+				Settings.NumTraceWorkers = FMath::Max(FCString::Atoi(*TraceWorkersString), 0);
+				for (const float Interval : Intervals)
+				{
+					Settings.TraceCheckInterval = Interval;
+					Runs.Add(Settings);
+				}
+			}
+		}
+
+		for (const FStarterBundleBenchmarkSettings& RunSettings : Runs)
+		{
+			const FStarterBundleBenchmarkResult Result = RunBenchmark(RunSettings, Params, Mesh, Montage, Sockets);
+
+			int64 NumMissedHits = -1;
+			if (bCountMissedHits)
+			{
+				NumMissedHits = 0;
+				for (const uint64 HitKey : ReferenceHitKeys)
+				{
+					NumMissedHits += Result.HitKeys.Contains(HitKey) ? 0 : 1;
+				}
+			}
+
+			const FString Line = FString::Printf(TEXT("%d,%d,%d,%.4f,%d,%.4f,%.1f,%lld,%lld,%lld,%lld"), RunSettings.NumActors, RunSettings.bUseBatching ? 1 : 0,
+				RunSettings.NumTraceWorkers, RunSettings.TraceCheckInterval, Result.NumFrames, Result.GameThreadMsPerFrame, Result.SweepsPerSecond, Result.NumSweeps,
+				Result.NumHits, NumMissedHits, Result.NumTraceLoopAllocations);
+			UE_LOG(LogStarterBundleBenchmark, Display, TEXT("%s"), *Line);
+			Csv += Line + TEXT("\n");
+
+			if (bCheckAllocations && Result.NumTraceLoopAllocations > 0)
+			{
+				UE_LOG(LogStarterBundleBenchmark, Error, TEXT("Trace loop made %lld heap allocations with %d actors, expected none in steady state"),
+					Result.NumTraceLoopAllocations, RunSettings.NumActors);
+				bHasTraceLoopAllocations = true;
+			}
+		}
+	}
+
+	if (FFileHelper::SaveStringToFile(Csv, *OutputPath) == false)
+	{
+		UE_LOG(LogStarterBundleBenchmark, Error, TEXT("Couldn't write results to %s"), *OutputPath);
+		return 1;
+	}
+
+	UE_LOG(LogStarterBundleBenchmark, Display, TEXT("Results written to %s"), *OutputPath);
+	return bHasTraceLoopAllocations ? 1 : 0;
+}
+
+FStarterBundleBenchmarkResult UStarterBundleBenchmarkCommandlet::RunBenchmark(const FStarterBundleBenchmarkSettings& Settings, const FString& Params, USkeletalMesh* Mesh, UAnimMontage* Montage, const TArray<FName>& Sockets)
+{
+	using namespace StarterBundleBenchmark;
+
+	int32 NumFrames = 600;
+	FParse::Value(*Params, TEXT("Frames="), NumFrames);
+	int32 NumWarmupFrames = 60;
+	FParse::Value(*Params, TEXT("WarmupFrames="), NumWarmupFrames);
+	float Fps = 60.f;
+	FParse::Value(*Params, TEXT("Fps="), Fps);
+	const float DeltaTime = 1.f / FMath::Max(Fps, 1.f);
+	const int32 NumActors = Settings.NumActors;
+	const bool bUseAsync = FParse::Param(*Params, TEXT("Async"));
+	const bool bUseNarrowphase = FParse::Param(*Params, TEXT("Narrowphase"));
+	const bool bUseBroadphase = FParse::Param(*Params, TEXT("Broadphase"));
+	const bool bUseSyntheticWindows = HasCollisionWindows(Montage) == false;
+	const bool bCheckAllocations = FParse::Param(*Params, TEXT("CheckAllocations"));
+	float AdaptiveError = 0.f;
+	FParse::Value(*Params, TEXT("AdaptiveError="), AdaptiveError);
+	const bool bInterpolateArc = FParse::Param(*Params, TEXT("InterpolateArc"));
+	int32 ArcSubsteps = 0;
+	FParse::Value(*Params, TEXT("ArcSubsteps="), ArcSubsteps);
+
+	// reference run sweeps straight lines at its fixed interval, so it doesn't depend on options being measured
+	if (Settings.bIsReference)
+	{
+		AdaptiveError = 0.f;
+	}
+
+	UWorld* World = CreateBenchmarkWorld();
+
+	if (UCollisionHandlerSubsystem* Subsystem = World->GetSubsystem<UCollisionHandlerSubsystem>())
+	{
+		Subsystem->SetNumParallelTraceWorkers(Settings.NumTraceWorkers);
+	}
+
+	// square grid of actors facing +X, so swings of neighbours overlap
+	TArray<FBenchmarkActor> BenchmarkActors;
+	const int32 GridSize = FMath::CeilToInt(FMath::Sqrt((float)NumActors));
+	int64 NumHits = 0;
+	TSet<uint64> HitKeys;
+	TMap<const AActor*, int32> ActorIndices;
+	TArray<int32> ActivationCounts;
+	ActivationCounts.SetNumZeroed(NumActors);
+	for (int32 Index = 0; Index < NumActors; ++Index)
+	{
+		const FVector Location((Index % GridSize) * ActorSpacing, (Index / GridSize) * ActorSpacing, 0.f);
+		const FRotator Rotation(0.f, (Index % 2) * 180.f, 0.f);
+
+		FBenchmarkActor BenchmarkActor;
+		BenchmarkActor.Actor = World->SpawnActor<AActor>(AActor::StaticClass(), FTransform(Rotation, Location));
+
+		BenchmarkActor.Mesh = NewObject<USkeletalMeshComponent>(BenchmarkActor.Actor, TEXT("Mesh"));
+		BenchmarkActor.Mesh->SetSkeletalMesh(Mesh);
+		BenchmarkActor.Mesh->SetAnimationMode(EAnimationMode::AnimationBlueprint);
+		BenchmarkActor.Mesh->SetAnimInstanceClass(UAnimInstance::StaticClass());
+		BenchmarkActor.Mesh->VisibilityBasedAnimTickOption = EVisibilityBasedAnimTickOption::AlwaysTickPoseAndRefreshBones;
+		BenchmarkActor.Mesh->SetCollisionProfileName(TEXT("CharacterMesh"));
+		BenchmarkActor.Actor->SetRootComponent(BenchmarkActor.Mesh);
+		BenchmarkActor.Mesh->SetWorldTransform(FTransform(Rotation, Location));
+		BenchmarkActor.Mesh->RegisterComponent();
+
+		if (bUseNarrowphase || bUseBroadphase)
+		{
+			UHurtboxComponent* Hurtbox = NewObject<UHurtboxComponent>(BenchmarkActor.Actor, TEXT("Hurtbox"));
+			Hurtbox->SetHurtboxMesh(BenchmarkActor.Mesh);
+			Hurtbox->RegisterComponent();
+		}
+
+		BenchmarkActor.CollisionHandler = NewObject<UCollisionHandlerComponent>(BenchmarkActor.Actor, TEXT("CollisionHandler"));
+		BenchmarkActor.CollisionHandler->bUseBatchedTraceCheck = Settings.bUseBatching;
+		BenchmarkActor.CollisionHandler->bUseAsyncTrace = bUseAsync;
+		BenchmarkActor.CollisionHandler->bUseHurtboxNarrowphase = bUseNarrowphase;
+		BenchmarkActor.CollisionHandler->bUseHurtboxBroadphase = bUseBroadphase;
+		BenchmarkActor.CollisionHandler->bUseAdaptiveTraceInterval = AdaptiveError > 0.f;
+		BenchmarkActor.CollisionHandler->MaxTraceDistanceError = AdaptiveError;
+		BenchmarkActor.CollisionHandler->TraceRadius = 5.f;
+		BenchmarkActor.CollisionHandler->bInterpolateSocketArc = bInterpolateArc && Settings.bIsReference == false;
+		if (ArcSubsteps > 0)
+		{
+			BenchmarkActor.CollisionHandler->ArcSubsteps = ArcSubsteps;
+		}
+		if (Settings.TraceCheckInterval > 0.f)
+		{
+			BenchmarkActor.CollisionHandler->TraceCheckInterval = Settings.TraceCheckInterval;
+		}
+		BenchmarkActor.CollisionHandler->RegisterComponent();
+		BenchmarkActor.CollisionHandler->UpdateCollidingComponentAndSockets(BenchmarkActor.Mesh, Sockets);
+
+		// montages play in lockstep in every run, so the same attacker, activation and victim identify the same hit across runs
+		ActorIndices.Add(BenchmarkActor.Actor, Index);
+		BenchmarkActor.CollisionHandler->OnCollisionActivatedtNative.AddLambda([&ActivationCounts, Index](ECollisionPart) { ++ActivationCounts[Index]; });
+		BenchmarkActor.CollisionHandler->OnHitNative.AddLambda([&NumHits, &HitKeys, &ActorIndices, &ActivationCounts, Index](FHitResult HitResult)
+		{
+			++NumHits;
+			if (const int32* VictimIndex = ActorIndices.Find(HitResult.GetActor()))
+			{
+				HitKeys.Add(MakeHitKey(Index, ActivationCounts[Index], *VictimIndex));
+			}
+		});
+
+		// rotating component spins its owner, so it is measured too and sockets move even if montage pose isn't applied
+		BenchmarkActor.RotatingComponent = NewObject<URotatingComponent>(BenchmarkActor.Actor, TEXT("RotatingComponent"));
+		BenchmarkActor.RotatingComponent->RegisterComponent();
+		AActor* Owner = BenchmarkActor.Actor;
+		BenchmarkActor.RotatingComponent->DesiredRotationProvider.BindLambda([Owner]() { return Owner->GetActorRotation() + FRotator(0.f, 90.f, 0.f); });
+
+		BenchmarkActors.Add(BenchmarkActor);
+	}
+
+	int64 NumSweepsAtStart = 0;
+	double GameThreadSeconds = 0.0;
+	const int32 TotalFrames = NumWarmupFrames + NumFrames;
+	for (int32 Frame = 0; Frame < TotalFrames; ++Frame)
+	{
+		if (Frame == NumWarmupFrames)
+		{
+#if !UE_BUILD_SHIPPING
+			// buffers of trace loop have grown during warmup, from now on it should not allocate
+			if (bCheckAllocations)
+			{
+				CountingMalloc.Inner = GMalloc;
+				CountingMalloc.NumAllocations.Reset();
+				GMalloc = &CountingMalloc;
+			}
+#endif
+			NumHits = 0;
+			for (const FBenchmarkActor& BenchmarkActor : BenchmarkActors)
+			{
+				NumSweepsAtStart += BenchmarkActor.CollisionHandler->GetNumSweepsIssued();
+			}
+		}
+
+		const double FrameStartTime = FPlatformTime::Seconds();
+
+		// keep montages and rotations looping, activate collision by hand if montage has no collision windows
+		for (const FBenchmarkActor& BenchmarkActor : BenchmarkActors)
+		{
+			UAnimInstance* AnimInstance = BenchmarkActor.Mesh->GetAnimInstance();
+			if (AnimInstance && AnimInstance->Montage_IsPlaying(Montage) == false)
+			{
+				AnimInstance->Montage_Play(Montage);
+			}
+			if (BenchmarkActor.RotatingComponent->IsRotating() == false)
+			{
+				BenchmarkActor.RotatingComponent->StartRotating(Montage->GetPlayLength(), 360.f);
+			}
+			if (bUseSyntheticWindows && AnimInstance)
+			{
+				const float Alpha = AnimInstance->Montage_GetPosition(Montage) / FMath::Max(Montage->GetPlayLength(), KINDA_SMALL_NUMBER);
+				const bool bShouldBeActive = Alpha >= SyntheticWindowStart && Alpha <= SyntheticWindowEnd;
+				if (bShouldBeActive && BenchmarkActor.CollisionHandler->IsCollisionActivated() == false)
+				{
+					BenchmarkActor.CollisionHandler->ActivateCollision(ECollisionPart::PrimaryItem);
+				}
+				else if (bShouldBeActive == false && BenchmarkActor.CollisionHandler->IsCollisionActivated())
+				{
+					BenchmarkActor.CollisionHandler->DeactivateCollision();
+				}
+			}
+		}
+
+		World->Tick(LEVELTICK_All, DeltaTime);
+
+		if (Frame >= NumWarmupFrames)
+		{
+			GameThreadSeconds += FPlatformTime::Seconds() - FrameStartTime;
+		}
+	}
+
+	int64 NumTraceLoopAllocations = 0;
+#if !UE_BUILD_SHIPPING
+	if (GMalloc == &CountingMalloc)
+	{
+		GMalloc = CountingMalloc.Inner;
+		NumTraceLoopAllocations = CountingMalloc.NumAllocations.GetValue();
+	}
+#endif
+
+	int64 NumSweeps = -NumSweepsAtStart;
+	for (const FBenchmarkActor& BenchmarkActor : BenchmarkActors)
+	{
+		NumSweeps += BenchmarkActor.CollisionHandler->GetNumSweepsIssued();
+	}
+
+	FStarterBundleBenchmarkResult Result;
+	Result.Settings = Settings;
+	Result.NumFrames = NumFrames;
+	Result.GameThreadMsPerFrame = NumFrames > 0 ? GameThreadSeconds * 1000.0 / NumFrames : 0.0;
+	Result.SweepsPerSecond = NumFrames > 0 ? NumSweeps / (NumFrames * DeltaTime) : 0.0;
+	Result.NumSweeps = NumSweeps;
+	Result.NumHits = NumHits;
+	Result.NumTraceLoopAllocations = NumTraceLoopAllocations;
+	Result.HitKeys = MoveTemp(HitKeys);
+
+	for (const FBenchmarkActor& BenchmarkActor : BenchmarkActors)
+	{
+		BenchmarkActor.CollisionHandler->OnHitNative.Clear();
+		BenchmarkActor.CollisionHandler->OnCollisionActivatedtNative.Clear();
+	}
+	DestroyBenchmarkWorld(World);
+
+	return Result;
+}
+
+int32 UStarterBundleBenchmarkCommandlet::RunMicrobenchmarks(const FString& MicroValue, const FString& Params, USkeletalMesh* Mesh, UAnimMontage* Montage, const TArray<FName>& Sockets)
+{
+	using namespace StarterBundleBenchmark;
+
+	int32 NumIterations = 100000;
+	FParse::Value(*Params, TEXT("MicroIterations="), NumIterations);
+	int32 NumExtraComponents = 8;
+	FParse::Value(*Params, TEXT("MicroComponents="), NumExtraComponents);
+	FString OutputPath = FPaths::ProjectSavedDir() / TEXT("Benchmarks/StarterBundleMicro.csv");
+	FParse::Value(*Params, TEXT("MicroOutput="), OutputPath);
+
+	int32 NumMicroActors = 200;
+	FParse::Value(*Params, TEXT("MicroActors="), NumMicroActors);
+	NumMicroActors = FMath::Max(NumMicroActors, 1);
+	int32 NumMicroSockets = 8;
+	FParse::Value(*Params, TEXT("MicroSockets="), NumMicroSockets);
+	NumMicroSockets = FMath::Max(NumMicroSockets, 1);
+
+	TArray<FString> Benchmarks;
+	MicroValue.ParseIntoArray(Benchmarks, TEXT(","));
+
+	// -Sockets are topped up with bones scattered over the skeleton by prime stride, e.g. like blade with several sockets
+	TArray<FName> MicroSockets(Sockets);
+	const FReferenceSkeleton& RefSkeleton = Mesh->RefSkeleton;
+	const int32 NumBones = RefSkeleton.GetNum();
+	for (int32 Index = 0; Index < NumBones && MicroSockets.Num() < NumMicroSockets; ++Index)
+	{
+		MicroSockets.AddUnique(RefSkeleton.GetBoneName((Index * 7919) % NumBones));
+	}
+	MicroSockets.SetNum(FMath::Min(MicroSockets.Num(), NumMicroSockets));
+
+	// posed actors spread over the world, world isn't ticked during microbenchmarks
+	UWorld* World = CreateBenchmarkWorld();
+	TArray<FBenchmarkActor> MicroActors;
+	for (int32 ActorIndex = 0; ActorIndex < NumMicroActors; ++ActorIndex)
+	{
+		const FVector Location(200.f * (ActorIndex % 20), 200.f * (ActorIndex / 20), 0.f);
+		FBenchmarkActor MicroActor = {};
+		MicroActor.Actor = World->SpawnActor<AActor>(AActor::StaticClass(), FTransform(Location));
+		MicroActor.Mesh = NewObject<USkeletalMeshComponent>(MicroActor.Actor, TEXT("Mesh"));
+		MicroActor.Mesh->SetSkeletalMesh(Mesh);
+		MicroActor.Actor->SetRootComponent(MicroActor.Mesh);
+		MicroActor.Mesh->RegisterComponent();
+		MicroActor.Mesh->RefreshBoneTransforms();
+
+		// components owned by typical character, registered before handler so class scan walks past them
+		for (int32 ComponentIndex = 0; ComponentIndex < NumExtraComponents; ++ComponentIndex)
+		{
+			USceneComponent* ExtraComponent = NewObject<USceneComponent>(MicroActor.Actor);
+			ExtraComponent->SetupAttachment(MicroActor.Mesh);
+			ExtraComponent->RegisterComponent();
+		}
+
+		MicroActor.CollisionHandler = NewObject<UCollisionHandlerComponent>(MicroActor.Actor, TEXT("CollisionHandler"));
+		MicroActor.CollisionHandler->RegisterComponent();
+		MicroActors.Add(MicroActor);
+	}
+	AActor* Actor = MicroActors[0].Actor;
+	USkeletalMeshComponent* MeshComponent = MicroActors[0].Mesh;
+
+	FString Csv = TEXT("Benchmark,Variant,Iterations,NsPerIteration\n");
+	for (const FString& Benchmark : Benchmarks)
+	{
+		if (Benchmark == TEXT("Sockets"))
+		{
+			// every pass samples all sockets of all actors like one frame of trace loop, results are per socket sample
+			const int32 NumPasses = FMath::Max(NumIterations / NumMicroActors, 1);
+			const int32 NumSocketSamples = NumPasses * NumMicroActors * MicroSockets.Num();
+
+			// name lookup and full socket transform per socket into map keyed by name, as trace loop sampled sockets before they were resolved
+			TArray<TMap<FName, FVector>> NamedSocketLocations;
+			NamedSocketLocations.SetNum(NumMicroActors);
+			double StartTime = FPlatformTime::Seconds();
+			for (int32 Pass = 0; Pass < NumPasses; ++Pass)
+			{
+				for (int32 ActorIndex = 0; ActorIndex < NumMicroActors; ++ActorIndex)
+				{
+					USkeletalMeshComponent* ActorMesh = MicroActors[ActorIndex].Mesh;
+					for (const FName& Socket : MicroSockets)
+					{
+						NamedSocketLocations[ActorIndex].Add(Socket, ActorMesh->GetSocketLocation(Socket));
+					}
+				}
+			}
+			AddMicroResult(Csv, TEXT("Sockets"), TEXT("NameLookupMap"), NumSocketSamples, FPlatformTime::Seconds() - StartTime);
+
+			// sockets resolved once, locations of all sockets computed in one batch into flat arrays
+			TArray<FCollisionPartState> Parts;
+			Parts.SetNum(NumMicroActors);
+			for (int32 ActorIndex = 0; ActorIndex < NumMicroActors; ++ActorIndex)
+			{
+				Parts[ActorIndex].CollidingComponent = MicroActors[ActorIndex].Mesh;
+				Parts[ActorIndex].Sockets = MicroSockets;
+				UCollisionHandlerComponent::ResolveSocketBindings(Parts[ActorIndex]);
+			}
+			StartTime = FPlatformTime::Seconds();
+			for (int32 Pass = 0; Pass < NumPasses; ++Pass)
+			{
+				for (int32 ActorIndex = 0; ActorIndex < NumMicroActors; ++ActorIndex)
+				{
+					MicroActors[ActorIndex].CollisionHandler->SampleSocketLocations(Parts[ActorIndex]);
+					MicroActors[ActorIndex].CollisionHandler->UpdateSocketLocations(Parts[ActorIndex]);
+				}
+			}
+			AddMicroResult(Csv, TEXT("Sockets"), TEXT("ResolvedBindings"), NumSocketSamples, FPlatformTime::Seconds() - StartTime);
+		}
+		else if (Benchmark == TEXT("Notifies"))
+		{
+			// sum of pointers keeps lookups from being optimized out
+			UPTRINT Checksum = 0;
+
+			// lookup notifies did before owner-keyed registry
+			double StartTime = FPlatformTime::Seconds();
+			for (int32 Iteration = 0; Iteration < NumIterations; ++Iteration)
+			{
+				Checksum += (UPTRINT)Actor->GetComponentByClass(UCollisionHandlerComponent::StaticClass());
+			}
+			AddMicroResult(Csv, TEXT("Notifies"), TEXT("GetComponentByClass"), NumIterations, FPlatformTime::Seconds() - StartTime);
+
+			StartTime = FPlatformTime::Seconds();
+			for (int32 Iteration = 0; Iteration < NumIterations; ++Iteration)
+			{
+				Checksum += (UPTRINT)UCollisionHandlerComponent::FindCollisionHandler(Actor);
+			}
+			AddMicroResult(Csv, TEXT("Notifies"), TEXT("FindCollisionHandler"), NumIterations, FPlatformTime::Seconds() - StartTime);
+
+			// whole dispatch of notify window including activation and deactivation of the handler
+			UActivateCollisionNotifyState* NotifyState = NewObject<UActivateCollisionNotifyState>();
+			StartTime = FPlatformTime::Seconds();
+			for (int32 Iteration = 0; Iteration < NumIterations; ++Iteration)
+			{
+				NotifyState->NotifyBegin(MeshComponent, Montage, 0.f);
+				NotifyState->NotifyEnd(MeshComponent, Montage);
+			}
+			AddMicroResult(Csv, TEXT("Notifies"), TEXT("NotifyBeginEnd"), NumIterations, FPlatformTime::Seconds() - StartTime);
+
+			UE_LOG(LogStarterBundleBenchmark, Verbose, TEXT("Lookup checksum %llu"), (uint64)Checksum);
+		}
+		else
+		{
+			UE_LOG(LogStarterBundleBenchmark, Warning, TEXT("Unknown microbenchmark %s"), *Benchmark);
+		}
+	}
+
+	DestroyBenchmarkWorld(World);
+
+	if (FFileHelper::SaveStringToFile(Csv, *OutputPath) == false)
+	{
+		UE_LOG(LogStarterBundleBenchmark, Error, TEXT("Couldn't write results to %s"), *OutputPath);
+		return 1;
+	}
+
+	UE_LOG(LogStarterBundleBenchmark, Display, TEXT("Results written to %s"), *OutputPath);
+	return 0;
+}
+
+bool UStarterBundleBenchmarkCommandlet::HasCollisionWindows(const UAnimMontage* Montage)
+{
+	for (const FAnimNotifyEvent& NotifyEvent : Montage->Notifies)
+	{
+		if (NotifyEvent.NotifyStateClass && NotifyEvent.NotifyStateClass->IsA<UActivateCollisionNotifyState>())
+		{
+			return true;
+		}
+	}
+	return false;
+}
@@ -2,4 +2,17 @@
 
 
 #include "StarterBundleFunctionLibrary.h"
+#include "BakedSocketTrajectories.h"
+#include "Animation/AnimMontage.h"
 
+#if WITH_EDITOR
+bool UStarterBundleFunctionLibrary::BakeSocketTrajectories(UAnimMontage* Montage, USkeletalMesh* Mesh, const TArray<FName>& Sockets, float SampleRate)
+{
+	if (UBakedSocketTrajectories::Bake(Montage, Mesh, Sockets, SampleRate))
+	{
+		Montage->MarkPackageDirty();
+		return true;
+	}
+	return false;
+}
+#endif
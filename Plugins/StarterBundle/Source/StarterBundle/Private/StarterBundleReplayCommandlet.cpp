@@ -0,0 +1,94 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "StarterBundleReplayCommandlet.h"
+#include "CollisionTrajectoryCapture.h"
+#include "CollisionTrajectoryReplay.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogStarterBundleReplay, Log, All);
+
+UStarterBundleReplayCommandlet::UStarterBundleReplayCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = false;
+	LogToConsole = true;
+}
+
+int32 UStarterBundleReplayCommandlet::Main(const FString& Params)
+{
+	FString Filename;
+	if (FParse::Value(*Params, TEXT("File="), Filename) == false)
+	{
+		UE_LOG(LogStarterBundleReplay, Error, TEXT("Missing -File= with captured trajectories"));
+		return 1;
+	}
+
+	FCollisionReplaySettings Settings;
+	FParse::Value(*Params, TEXT("Radius="), Settings.TraceRadius);
+	FParse::Value(*Params, TEXT("Stride="), Settings.SampleStride);
+	FParse::Value(*Params, TEXT("ArcSubsteps="), Settings.ArcSubsteps);
+	int32 NumIterations = 1;
+	FParse::Value(*Params, TEXT("Iterations="), NumIterations);
+	FString OutputPath = FPaths::ProjectSavedDir() / TEXT("Benchmarks/StarterBundleReplay.csv");
+	FParse::Value(*Params, TEXT("Output="), OutputPath);
+	FString BaselinePath;
+	FParse::Value(*Params, TEXT("Baseline="), BaselinePath);
+
+	FCapturedTrajectories Trajectories;
+	if (FCollisionTrajectoryWriter::LoadFromFile(Filename, Trajectories) == false)
+	{
+		UE_LOG(LogStarterBundleReplay, Error, TEXT("Couldn't read trajectories from %s"), *Filename);
+		return 1;
+	}
+
+	// hits are taken from the first iteration, the rest only adds to timing
+	FCollisionReplayResult Result;
+	FCollisionTrajectoryReplay::Run(Trajectories, Settings, Result);
+	double Seconds = Result.Seconds;
+	for (int32 Iteration = 1; Iteration < NumIterations; ++Iteration)
+	{
+		FCollisionReplayResult IterationResult;
+		FCollisionTrajectoryReplay::Run(Trajectories, Settings, IterationResult);
+		Seconds += IterationResult.Seconds;
+	}
+
+	UE_LOG(LogStarterBundleReplay, Display, TEXT("Activations %d, samples %d, sweeps %lld, hits %d, %.4f ms per replay"),
+		Result.NumActivations, Result.NumSamples, Result.NumSweeps, Result.Hits.Num(), Seconds * 1000.0 / FMath::Max(NumIterations, 1));
+
+	FString Csv = TEXT("Activation,Sample,Target,Bone\n");
+	for (const FCollisionReplayHit& ReplayHit : Result.Hits)
+	{
+		Csv += FString::Printf(TEXT("%d,%d,%u,%s\n"), ReplayHit.ActivationIndex, ReplayHit.SampleIndex, ReplayHit.TargetId, *ReplayHit.BoneName.ToString());
+	}
+
+	if (FFileHelper::SaveStringToFile(Csv, *OutputPath) == false)
+	{
+		UE_LOG(LogStarterBundleReplay, Error, TEXT("Couldn't write hits to %s"), *OutputPath);
+		return 1;
+	}
+
+	if (BaselinePath.IsEmpty() == false)
+	{
+		FString BaselineCsv;
+		if (FFileHelper::LoadFileToString(BaselineCsv, *BaselinePath) == false)
+		{
+			UE_LOG(LogStarterBundleReplay, Error, TEXT("Couldn't read baseline %s"), *BaselinePath);
+			return 1;
+		}
+
+		TArray<FString> BaselineLines, Lines;
+		BaselineCsv.ParseIntoArrayLines(BaselineLines);
+		Csv.ParseIntoArrayLines(Lines);
+		if (BaselineLines != Lines)
+		{
+			UE_LOG(LogStarterBundleReplay, Error, TEXT("Hits differ from baseline %s: %d hits, baseline has %d"), *BaselinePath, Lines.Num() - 1, BaselineLines.Num() - 1);
+			return 1;
+		}
+		UE_LOG(LogStarterBundleReplay, Display, TEXT("Hits match baseline %s"), *BaselinePath);
+	}
+
+	return 0;
+}
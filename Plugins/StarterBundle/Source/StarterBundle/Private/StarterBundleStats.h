@@ -0,0 +1,115 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Stats/Stats.h"
+#include "ProfilingDebugging/CsvProfiler.h"
+#include "Runtime/Launch/Resources/Version.h"
+
+#if ENGINE_MAJOR_VERSION > 4 || ENGINE_MINOR_VERSION >= 25
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+/* CPU scope visible in Unreal Insights */
+#define STARTERBUNDLE_TRACE_CPU_SCOPE(Name) TRACE_CPUPROFILER_EVENT_SCOPE(Name)
+#else
+/* Named event visible in external profilers, engine versions before Insights */
+#define STARTERBUNDLE_TRACE_CPU_SCOPE(Name) SCOPED_NAMED_EVENT(Name, FColor::Orange)
+#endif
+
+/* Stat group of the whole plugin, use "stat StarterBundle" to display it */
+DECLARE_STATS_GROUP(TEXT("StarterBundle"), STATGROUP_StarterBundle, STATCAT_Advanced);
+
+/* CSV profiler category of the whole plugin, use "csvcategory StarterBundle" to toggle it */
+CSV_DECLARE_CATEGORY_EXTERN(StarterBundle);
+
+/* Measures scope with cycle counter, CSV profiler timing stat and CPU trace scope */
+#define STARTERBUNDLE_SCOPE_CYCLE_COUNTER(Stat) \
+	SCOPE_CYCLE_COUNTER(Stat); \
+	CSV_SCOPED_TIMING_STAT(StarterBundle, Stat); \
+	STARTERBUNDLE_TRACE_CPU_SCOPE(Stat)
+
+/* Increments per frame counter both in stats and in CSV profiler */
+#define STARTERBUNDLE_INC_COUNTER(Stat, Amount) \
+	INC_DWORD_STAT_BY(Stat, Amount); \
+	CSV_CUSTOM_STAT(StarterBundle, Stat, (int32)(Amount), ECsvCustomStatOp::Accumulate)
+
+#if !UE_BUILD_SHIPPING
+/**
+ * Marks code whose heap allocations should be counted, e.g. by benchmark commandlet with -CheckAllocations.
+ * Scopes nest, scope with bTrack false pauses counting inside tracked code (e.g. hit callbacks).
+ * Tracking is per thread, so scopes opened by worker threads count their own allocations without affecting game thread.
+ */
+struct FStarterBundleAllocationScope
+{
+	explicit FStarterBundleAllocationScope(bool bTrack)
+		: bWasTracking(bIsTracking)
+	{
+		bIsTracking = bTrack;
+	}
+
+	~FStarterBundleAllocationScope()
+	{
+		bIsTracking = bWasTracking;
+	}
+
+	/* Whether calling thread is currently inside tracked scope */
+	static thread_local bool bIsTracking;
+
+private:
+	bool bWasTracking;
+};
+
+#define STARTERBUNDLE_ALLOCATION_SCOPE(bTrack) FStarterBundleAllocationScope StarterBundleAllocationScope(bTrack)
+#else
+#define STARTERBUNDLE_ALLOCATION_SCOPE(bTrack)
+#endif
+
+/* Time spent in trace checks started by per-component looping timers */
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Timer Trace Check"), STAT_TimerTraceCheck, STATGROUP_StarterBundle, );
+
+/* Time spent in trace checks driven by pose updates of skeletal meshes */
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Pose Trace Check"), STAT_PoseTraceCheck, STATGROUP_StarterBundle, );
+
+/* Time spent in single batched pass of CollisionHandlerSubsystem */
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Batched Trace Check"), STAT_BatchedTraceCheck, STATGROUP_StarterBundle, );
+
+/* Time game thread spends in sweeps of handlers spread over worker threads, including waiting for workers */
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Parallel Sweeps"), STAT_ParallelSweeps, STATGROUP_StarterBundle, );
+
+/* Time spent computing socket locations of collision handlers */
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Update Socket Locations"), STAT_UpdateSocketLocations, STATGROUP_StarterBundle, );
+
+/* Time spent in sweeps of collision handlers, including hit processing */
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Perform Trace Check"), STAT_PerformTraceCheck, STATGROUP_StarterBundle, );
+
+/* Time spent posing hurtbox capsules and rebuilding broadphase grid */
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Update Hurtboxes"), STAT_UpdateHurtboxes, STATGROUP_StarterBundle, );
+
+/* Time spent processing results of async sweeps */
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Async Trace Results"), STAT_AsyncTraceResults, STATGROUP_StarterBundle, );
+
+/* Time spent in OnHit callbacks */
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Notify On Hit"), STAT_NotifyOnHit, STATGROUP_StarterBundle, );
+
+/* Time spent rotating owners of rotating components */
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Update Rotation"), STAT_UpdateRotation, STATGROUP_StarterBundle, );
+
+/* Time spent in StarterBundle anim notifies, including lookup of owner components */
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Anim Notify Dispatch"), STAT_AnimNotifyDispatch, STATGROUP_StarterBundle, );
+
+/* Number of collision handlers with activated collision */
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Active Handlers"), STAT_ActiveCollisionHandlers, STATGROUP_StarterBundle, );
+
+/* Number of currently rotating components */
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Rotating Actors"), STAT_RotatingActors, STATGROUP_StarterBundle, );
+
+/* Per frame counters of collision handler sweeps and hits */
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Sweeps Issued"), STAT_SweepsIssued, STATGROUP_StarterBundle, );
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Hit Results Returned"), STAT_HitResultsReturned, STATGROUP_StarterBundle, );
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Hits Filtered"), STAT_HitsFiltered, STATGROUP_StarterBundle, );
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Hits Delivered"), STAT_HitsDelivered, STATGROUP_StarterBundle, );
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Trace Checks Culled By Broadphase"), STAT_TraceChecksCulled, STATGROUP_StarterBundle, );
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Midpoint Overlaps"), STAT_MidpointOverlaps, STATGROUP_StarterBundle, );
+
+/* Memory used by hit validation history of all collision handlers */
+DECLARE_MEMORY_STAT_EXTERN(TEXT("Hit History Memory"), STAT_HitHistoryMemory, STATGROUP_StarterBundle, );
@@ -0,0 +1,57 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "CollisionHandlerComponent.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace CollisionFidelityTierTest
+{
+	/* Checks that every tier can be entered from its neighbours with given hysteresis */
+	void TestTiersReachable(FAutomationTestBase& Test, const TCHAR* What, const TArray<FCollisionFidelityTier>& Tiers, float Hysteresis)
+	{
+		for (int32 CurrentTier = 0; CurrentTier < Tiers.Num(); ++CurrentTier)
+		{
+			// raising targets previous tier from its MinSignificance up to 1
+			if (CurrentTier > 0)
+			{
+				const float Threshold = UCollisionHandlerComponent::GetFidelityTierChangeThreshold(Tiers, CurrentTier, true, Hysteresis);
+				Test.TestTrue(FString::Printf(TEXT("%s: tier %d can be raised, threshold %f"), What, CurrentTier, Threshold),
+					Threshold >= Tiers[CurrentTier - 1].MinSignificance && Threshold <= 1.f);
+			}
+
+			// lowering targets next tier below current MinSignificance, which has to be above MinSignificance of next tier
+			if (CurrentTier + 1 < Tiers.Num())
+			{
+				const float Threshold = UCollisionHandlerComponent::GetFidelityTierChangeThreshold(Tiers, CurrentTier, false, Hysteresis);
+				Test.TestTrue(FString::Printf(TEXT("%s: tier %d can be lowered, threshold %f"), What, CurrentTier, Threshold),
+					Threshold > Tiers[CurrentTier + 1].MinSignificance && Threshold <= Tiers[CurrentTier].MinSignificance);
+			}
+		}
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FCollisionFidelityTierThresholdTest, "StarterBundle.CollisionHandler.FidelityTierThresholds",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FCollisionFidelityTierThresholdTest::RunTest(const FString& Parameters)
+{
+	using namespace CollisionFidelityTierTest;
+
+	// defaults used to make the midpoint overlap tier unreachable, threshold of lowering from tier 2 was 0
+	const UCollisionHandlerComponent* Defaults = GetDefault<UCollisionHandlerComponent>();
+	TestTiersReachable(*this, TEXT("Defaults"), Defaults->FidelityTiers, Defaults->SignificanceSettings.Hysteresis);
+
+	// hysteresis bigger than gaps between tiers
+	TArray<FCollisionFidelityTier> Tiers;
+	Tiers.Add(FCollisionFidelityTier(0.95f, 1.f, 0, false, false));
+	Tiers.Add(FCollisionFidelityTier(0.9f, 2.f, 2, false, false));
+	Tiers.Add(FCollisionFidelityTier(0.05f, 4.f, 2, true, false));
+	Tiers.Add(FCollisionFidelityTier(0.f, 1.f, 0, false, true));
+	TestTiersReachable(*this, TEXT("Large hysteresis"), Tiers, 0.3f);
+
+	return true;
+}
+
+#endif
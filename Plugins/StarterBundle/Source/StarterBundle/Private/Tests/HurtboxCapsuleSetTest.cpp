@@ -0,0 +1,123 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "HurtboxCapsuleSet.h"
+#include "Misc/AutomationTest.h"
+#include "Math/RandomStream.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace HurtboxCapsuleSetTest
+{
+	/* Distances closer than this to sum of radii may be classified differently by vectorized and scalar math */
+	const float BoundaryTolerance = 0.01f;
+
+	FVector RandomPoint(FRandomStream& Random)
+	{
+		return FVector(Random.FRandRange(-200.f, 200.f), Random.FRandRange(-200.f, 200.f), Random.FRandRange(-200.f, 200.f));
+	}
+
+	/* Returns end of segment starting at Start, zero length for every third segment */
+	FVector RandomEnd(FRandomStream& Random, const FVector& Start, int32 Index)
+	{
+		return Index % 3 == 0 ? Start : Start + Random.VRand() * Random.FRandRange(0.f, 150.f);
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FHurtboxCapsuleSetSegmentDistTest, "StarterBundle.HurtboxCapsuleSet.SegmentDistSquared",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FHurtboxCapsuleSetSegmentDistTest::RunTest(const FString& Parameters)
+{
+	using namespace HurtboxCapsuleSetTest;
+
+	FRandomStream Random(1337);
+	for (int32 Index = 0; Index < 1000; ++Index)
+	{
+		const FVector P1 = RandomPoint(Random);
+		const FVector Q1 = RandomEnd(Random, P1, Index);
+		const FVector P2 = RandomPoint(Random);
+		const FVector Q2 = RandomEnd(Random, P2, Index / 3);
+
+		FVector Closest1, Closest2;
+		const float DistSquared = FHurtboxCapsuleSet::SegmentDistSquared(P1, Q1, P2, Q2, Closest1, Closest2);
+
+		// engine reference handles points by its own branches
+		FVector ReferenceClosest1, ReferenceClosest2;
+		FMath::SegmentDistToSegmentSafe(P1, Q1, P2, Q2, ReferenceClosest1, ReferenceClosest2);
+		const float ReferenceDistSquared = FVector::DistSquared(ReferenceClosest1, ReferenceClosest2);
+
+		if (FMath::Abs(FMath::Sqrt(DistSquared) - FMath::Sqrt(ReferenceDistSquared)) > BoundaryTolerance)
+		{
+			AddError(FString::Printf(TEXT("Segments %d: distance %f, reference %f (P1 %s Q1 %s P2 %s Q2 %s)"), Index,
+				FMath::Sqrt(DistSquared), FMath::Sqrt(ReferenceDistSquared), *P1.ToString(), *Q1.ToString(), *P2.ToString(), *Q2.ToString()));
+		}
+	}
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FHurtboxCapsuleSetSweepSphereTest, "StarterBundle.HurtboxCapsuleSet.SweepSphere",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FHurtboxCapsuleSetSweepSphereTest::RunTest(const FString& Parameters)
+{
+	using namespace HurtboxCapsuleSetTest;
+
+	FRandomStream Random(7);
+
+	// count not divisible by 4, so padding lanes of last vector are tested too
+	FHurtboxCapsuleSet Capsules;
+	for (int32 Index = 0; Index < 203; ++Index)
+	{
+		const FVector Start = RandomPoint(Random);
+		Capsules.Add(Start, RandomEnd(Random, Start, Index), Random.FRandRange(5.f, 40.f), Index, NAME_None);
+	}
+
+	TArray<FHurtboxCapsuleHit> Hits;
+	TArray<FHurtboxCapsuleHit> ScalarHits;
+	for (int32 SweepIndex = 0; SweepIndex < 300; ++SweepIndex)
+	{
+		const FVector Start = RandomPoint(Random);
+		const FVector End = RandomEnd(Random, Start, SweepIndex);
+		const float SphereRadius = Random.FRandRange(0.f, 30.f);
+
+		Hits.Reset();
+		ScalarHits.Reset();
+		Capsules.SweepSphere(Start, End, SphereRadius, Hits);
+		Capsules.SweepSphereScalar(Start, End, SphereRadius, ScalarHits);
+
+		TArray<bool> IsHit, IsScalarHit;
+		IsHit.SetNumZeroed(Capsules.Num());
+		IsScalarHit.SetNumZeroed(Capsules.Num());
+		for (const FHurtboxCapsuleHit& Hit : Hits)
+		{
+			IsHit[Hit.CapsuleIndex] = true;
+		}
+		for (const FHurtboxCapsuleHit& Hit : ScalarHits)
+		{
+			IsScalarHit[Hit.CapsuleIndex] = true;
+		}
+
+		for (int32 CapsuleIndex = 0; CapsuleIndex < Capsules.Num(); ++CapsuleIndex)
+		{
+			if (IsHit[CapsuleIndex] == IsScalarHit[CapsuleIndex])
+			{
+				continue;
+			}
+
+			// capsules touching the sphere within rounding of reciprocal estimate may go either way
+			FVector SweepLocation, CapsuleLocation;
+			const float Dist = FMath::Sqrt(FHurtboxCapsuleSet::SegmentDistSquared(Start, End, Capsules.GetStart(CapsuleIndex), Capsules.GetEnd(CapsuleIndex), SweepLocation, CapsuleLocation));
+			if (FMath::Abs(Dist - (SphereRadius + Capsules.GetRadius(CapsuleIndex))) > BoundaryTolerance)
+			{
+				AddError(FString::Printf(TEXT("Sweep %d capsule %d: vectorized hit %d, scalar hit %d, distance %f, radius sum %f"), SweepIndex, CapsuleIndex,
+					IsHit[CapsuleIndex] ? 1 : 0, IsScalarHit[CapsuleIndex] ? 1 : 0, Dist, SphereRadius + Capsules.GetRadius(CapsuleIndex)));
+			}
+		}
+	}
+
+	return true;
+}
+
+#endif
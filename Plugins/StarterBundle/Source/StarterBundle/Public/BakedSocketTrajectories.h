@@ -0,0 +1,82 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/AssetUserData.h"
+#include "BakedSocketTrajectories.generated.h"
+
+class UAnimSequenceBase;
+class UAnimMontage;
+class USkeletalMesh;
+
+/**
+ * Socket locations sampled at fixed rate over single ActivateCollisionNotifyState window of a montage.
+ * Locations are in component space of the mesh playing the montage, sample-major: Locations[Sample * Sockets.Num() + Socket].
+ */
+USTRUCT()
+struct STARTERBUNDLE_API FBakedSocketTrajectoryWindow
+{
+	GENERATED_BODY()
+
+	FBakedSocketTrajectoryWindow()
+		: StartTime(0.f), EndTime(0.f), SampleInterval(0.f) {}
+
+	/* Montage position of the first and the last sample */
+	UPROPERTY(VisibleAnywhere, Category = "CollisionHandler")
+	float StartTime;
+
+	UPROPERTY(VisibleAnywhere, Category = "CollisionHandler")
+	float EndTime;
+
+	/* Time between two samples */
+	UPROPERTY(VisibleAnywhere, Category = "CollisionHandler")
+	float SampleInterval;
+
+	/* Names of baked sockets, order of locations within every sample */
+	UPROPERTY(VisibleAnywhere, Category = "CollisionHandler")
+	TArray<FName> Sockets;
+
+	UPROPERTY()
+	TArray<FVector> Locations;
+
+	/* Returns number of samples in window */
+	int32 GetNumSamples() const { return Sockets.Num() > 0 ? Locations.Num() / Sockets.Num() : 0; }
+
+	/* Whether given montage position is covered by window */
+	bool ContainsTime(float Time) const { return Time >= StartTime - KINDA_SMALL_NUMBER && Time <= EndTime + KINDA_SMALL_NUMBER; }
+
+	/* Returns component space location of socket at given montage position, samples are joined with Catmull-Rom spline */
+	FVector Sample(int32 SocketIndex, float Time) const;
+};
+
+/**
+ * Socket trajectories baked from montage, stored as asset user data of the montage.
+ * Allows collision handler to rebuild socket locations from montage position and mesh transform without evaluating the pose,
+ * so servers can use VisibilityBasedAnimTickOption and skip bone transforms of attacking characters.
+ */
+UCLASS()
+class STARTERBUNDLE_API UBakedSocketTrajectories : public UAssetUserData
+{
+	GENERATED_BODY()
+
+public:
+	/* One entry per ActivateCollisionNotifyState of montage, sorted by start time */
+	UPROPERTY(VisibleAnywhere, Category = "CollisionHandler")
+	TArray<FBakedSocketTrajectoryWindow> Windows;
+
+	/* Returns index of window covering given montage position, INDEX_NONE if there is none */
+	int32 FindWindow(float Time) const;
+
+	/* Returns baked trajectories of given animation, nullptr if it wasn't baked */
+	static UBakedSocketTrajectories* Get(const UAnimSequenceBase* Animation);
+
+#if WITH_EDITOR
+	/**
+	 * Samples pose of Mesh playing Montage over every ActivateCollisionNotifyState window and stores given sockets with the montage.
+	 * Root bone is kept in reference pose if montage uses root motion, the same as at runtime. Replaces previously baked data.
+	 * Returns baked data, nullptr if montage has no collision windows or none of sockets exists on Mesh.
+	 */
+	static UBakedSocketTrajectories* Bake(UAnimMontage* Montage, USkeletalMesh* Mesh, const TArray<FName>& Sockets, float SampleRate);
+#endif
+};
@@ -4,8 +4,16 @@
 
 #include "CoreMinimal.h"
 #include "Components/ActorComponent.h"
+#include "WorldCollision.h"
+#include "CollisionHitRegistry.h"
+#include "CollisionHistoryBuffer.h"
+#include "HurtboxCapsuleSet.h"
 #include "CollisionHandlerComponent.generated.h"
 
+class UAnimSequenceBase;
+class UAnimMontage;
+class USkeletalMeshComponent;
+class UBakedSocketTrajectories;
 
 /**
  * Enum which helps to determine on which part of body or weapon collision should be activated.
@@ -29,7 +37,8 @@ enum class ECollisionPart : uint8
 
 /**
  * Custom debug mode enum to avoid including Kismet System Library header.
- * In cpp file while doing trace check it will be converted to EDrawDebugTrace::Type
+ * First values match EDrawDebugTrace::Type, draw durations are the same as in Kismet trace functions.
+ * Record doesn't draw anything, it stores compact trace records in CollisionHandlerSubsystem, also works on headless servers
  */
 UENUM(BlueprintType)
 enum class ECollisionHandlerDebugMode : uint8
@@ -37,13 +46,195 @@ enum class ECollisionHandlerDebugMode : uint8
 	None,
 	ForOneFrame,
 	ForDuration,
-	Persistant
+	Persistant,
+	Record
+};
+
+/**
+ * Determines shape used to cover path of sockets between two trace checks.
+ * SocketSpheres does a sphere trace per socket, BladeCapsule treats sockets as a chain going from first to last socket
+ * (e.g. hilt to tip of a sword) and sweeps a single capsule covering whole chain.
+ */
+UENUM(BlueprintType)
+enum class ECollisionTraceShape : uint8
+{
+	SocketSpheres,
+	BladeCapsule
+};
+
+/**
+ * Fidelity of trace checks used by handler while its significance is at least MinSignificance.
+ * Lower tiers use longer intervals, fewer sockets and a single blade capsule instead of sphere per socket,
+ * the lowest tier may replace trace checks by single overlap test in the middle of activation.
+ */
+USTRUCT(BlueprintType)
+struct STARTERBUNDLE_API FCollisionFidelityTier
+{
+	GENERATED_BODY()
+
+	FCollisionFidelityTier()
+		: MinSignificance(0.f), IntervalScale(1.f), MaxSockets(0), bForceBladeCapsule(false), bMidpointOverlapOnly(false) {}
+
+	FCollisionFidelityTier(float InMinSignificance, float InIntervalScale, int32 InMaxSockets, bool bInForceBladeCapsule, bool bInMidpointOverlapOnly)
+		: MinSignificance(InMinSignificance), IntervalScale(InIntervalScale), MaxSockets(InMaxSockets), bForceBladeCapsule(bInForceBladeCapsule),
+		bMidpointOverlapOnly(bInMidpointOverlapOnly) {}
+
+	/* Lowest significance at which tier is used, tiers are ordered from full fidelity to the lowest one */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CollisionHandler", meta = (ClampMin = "0.0", ClampMax = "1.0"))
+	float MinSignificance;
+
+	/* Multiplier of trace check interval, including bounds of adaptive interval */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CollisionHandler", meta = (ClampMin = "1.0"))
+	float IntervalScale;
+
+	/* Max number of sockets swept, evenly picked from first to last one, 0 sweeps all sockets */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CollisionHandler", meta = (ClampMin = "0"))
+	int32 MaxSockets;
+
+	/* Whether sockets are swept as one blade capsule regardless of TraceShape */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CollisionHandler")
+	bool bForceBladeCapsule;
+
+	/* Whether trace checks are replaced by single overlap of sockets in the middle of activation window */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CollisionHandler")
+	bool bMidpointOverlapOnly;
+};
+
+/**
+ * Determines significance of collision handler in range 0-1, from distance of its owner to the nearest player,
+ * whether owner was recently rendered and whether a player takes part in the fight.
+ */
+USTRUCT(BlueprintType)
+struct STARTERBUNDLE_API FCollisionSignificanceSettings
+{
+	GENERATED_BODY()
+
+	FCollisionSignificanceSettings()
+		: FullSignificanceDistance(1500.f), ZeroSignificanceDistance(8000.f), HiddenSignificanceScale(0.5f), Hysteresis(0.1f),
+		MinTierDuration(1.f), UpdateInterval(0.25f) {}
+
+	/* Distance to the nearest player up to which significance is 1, also distance within which a player is considered involved in the fight */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CollisionHandler", meta = (ClampMin = "0.0"))
+	float FullSignificanceDistance;
+
+	/* Distance to the nearest player from which significance is 0 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CollisionHandler", meta = (ClampMin = "0.0"))
+	float ZeroSignificanceDistance;
+
+	/* Multiplier of significance of owners not rendered recently, not used on dedicated server */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CollisionHandler", meta = (ClampMin = "0.0", ClampMax = "1.0"))
+	float HiddenSignificanceScale;
+
+	/* How far significance has to get past threshold of a tier before tier is changed, at most half of the gap to threshold of neighbouring tier */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CollisionHandler", meta = (ClampMin = "0.0"))
+	float Hysteresis;
+
+	/* Min time in seconds between two tier changes */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CollisionHandler", meta = (ClampMin = "0.0"))
+	float MinTierDuration;
+
+	/* How often significance is computed while collision is activated */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CollisionHandler", meta = (ClampMin = "0.0"))
+	float UpdateInterval;
+};
+
+/* Single sweep between two locations of a socket, or of a blade center if HalfHeight is greater than zero */
+struct FCollisionSweepSegment
+{
+	FCollisionSweepSegment() {}
+	FCollisionSweepSegment(const FVector& InStart, const FVector& InEnd)
+		: Start(InStart), End(InEnd), Rotation(FQuat::Identity), HalfHeight(0.f), RadiusPadding(0.f) {}
+	FCollisionSweepSegment(const FVector& InStart, const FVector& InEnd, const FQuat& InRotation, float InHalfHeight, float InRadiusPadding = 0.f)
+		: Start(InStart), End(InEnd), Rotation(InRotation), HalfHeight(InHalfHeight), RadiusPadding(InRadiusPadding) {}
+
+	/* Whether segment is swept with capsule instead of sphere */
+	bool IsCapsule() const { return HalfHeight > 0.f; }
+
+	FVector Start;
+	FVector End;
+	FQuat Rotation;
+	float HalfHeight;
+
+	/* Added to TraceRadius, so capsule with fixed orientation still contains blade poses rotated away from its axis */
+	float RadiusPadding;
+};
+
+/* Collision socket resolved to bone index and offset relative to that bone, allows to compute socket location without name lookup */
+struct FCollisionSocketBinding
+{
+	FCollisionSocketBinding()
+		: BoneIndex(INDEX_NONE), LocalOffset(FVector::ZeroVector), bIsResolved(false) {}
+
+	/* Index of bone in colliding skinned mesh, INDEX_NONE if offset is relative to the component itself (static mesh socket) */
+	int32 BoneIndex;
+
+	/* Location of socket relative to bone or component */
+	FVector LocalOffset;
+
+	/* If false socket couldn't be resolved and its location is taken through GetSocketLocation */
+	bool bIsResolved;
+};
+
+/**
+ * Colliding component and sockets of single collision part, registered once and traced whenever the part is activated.
+ * Also keeps sampled socket locations of the part, so several parts can be activated at once without sharing them.
+ */
+USTRUCT()
+struct STARTERBUNDLE_API FCollisionPartState
+{
+	GENERATED_BODY()
+
+	FCollisionPartState()
+		: CollidingComponent(nullptr), TrajectorySourceMontage(nullptr), BakedTrajectories(nullptr), BakedWindowIndex(INDEX_NONE),
+		bHasSecondLastSocketLocations(false), bCanPerformTrace(false) {}
+
+	/* Component from which socket locations are taken, part isn't registered if null */
+	UPROPERTY()
+	UPrimitiveComponent* CollidingComponent;
+
+	UPROPERTY()
+	TArray<FName> Sockets;
+
+	/* Sockets resolved to bones, same order as Sockets */
+	TArray<FCollisionSocketBinding> SocketBindings;
+
+	/* Mesh asset that SocketBindings were resolved for */
+	TWeakObjectPtr<UObject> ResolvedMeshAsset;
+
+	/* Mesh and montage that activated the part */
+	TWeakObjectPtr<USkeletalMeshComponent> TrajectorySourceMesh;
+
+	UPROPERTY()
+	UAnimMontage* TrajectorySourceMontage;
+
+	/* Trajectories baked into TrajectorySourceMontage, set at activation only if bUseBakedTrajectories is set */
+	UPROPERTY()
+	UBakedSocketTrajectories* BakedTrajectories;
+
+	/* Baked window used by last sample and indices of Sockets within it */
+	int32 BakedWindowIndex;
+	TArray<int32> BakedSocketIndices;
+
+	/* Locations of sockets in current, last and second last sample, same order as Sockets */
+	TArray<FVector> CurrentSocketLocations;
+	TArray<FVector> LastSocketLocations;
+	TArray<FVector> SecondLastSocketLocations;
+
+	/* Whether SecondLastSocketLocations are valid, set only if bInterpolateSocketArc or bUseAdaptiveTraceInterval is set */
+	bool bHasSecondLastSocketLocations;
+
+	/* Whether last socket locations belong to current activation of the part, so trace check can be performed */
+	bool bCanPerformTrace;
 };
 
 /* Delegate called when there was a collision */
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnHit, const FHitResult&, HitResult);
 DECLARE_MULTICAST_DELEGATE_OneParam(FOnHitNative, FHitResult);
 
+/* Delegate called once per frame with all hits of the frame, if bDispatchHitsInBatches is set */
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnHitBatch, const TArray<FHitResult>&, HitResults);
+DECLARE_MULTICAST_DELEGATE_OneParam(FOnHitBatchNative, TArrayView<const FHitResult>);
+
 /* Delegate called when collision was activated */
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnCollisionActivated, ECollisionPart, CollisionPart);
 DECLARE_MULTICAST_DELEGATE_OneParam(FOnCollisionActivatedNative, ECollisionPart);
@@ -62,6 +253,9 @@ class STARTERBUNDLE_API UCollisionHandlerComponent : public UActorComponent
 {
 	GENERATED_BODY()
 
+	/* microbenchmarks measure socket sampling directly */
+	friend class UStarterBundleBenchmarkCommandlet;
+
 public:	
 	/* Constructor */
 	UCollisionHandlerComponent();
@@ -78,6 +272,100 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CollisionHandler")
 	float TraceCheckInterval;
 
+	/**
+	 * Whether trace checks should be done by CollisionHandlerSubsystem in one batched pass per frame together with other handlers.
+	 * If false (or subsystem is not available) component falls back to its own looping timer.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CollisionHandler")
+	uint32 bUseBatchedTraceCheck : 1;
+
+	/**
+	 * Whether trace checks should follow pose updates of skeletal mesh moving colliding component instead of subsystem or timer.
+	 * Every pose is sampled at most once right after its bones are finalized, TraceCheckInterval is then min time between samples (0 samples every pose).
+	 * Nothing is sampled while mesh doesn't refresh bones, e.g. off screen with VisibilityBasedAnimTickOption. Falls back to subsystem or timer without skeletal mesh.
+	 * Mesh of the first active part is followed, it's looked up again whenever parts are activated or deactivated.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CollisionHandler")
+	uint32 bSampleOnPoseUpdate : 1;
+
+	/**
+	 * Whether sweeps should be issued as async scene queries instead of blocking the game thread.
+	 * Hits are processed and OnHit is called when results come back on the next frame. Only Record debug mode is supported in this mode.
+	 * Results of the last sweeps of activation come back after deactivation, so OnHit may follow OnCollisionDeactivated.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CollisionHandler")
+	uint32 bUseAsyncTrace : 1;
+
+	/**
+	 * Whether socket sweeps should be tested against hurtbox capsules of actors with HurtboxComponent instead of physics scene.
+	 * Hit bone is taken directly from the capsule. Only actors with HurtboxComponent can be hit and ObjectTypesToCollideWith is not used.
+	 * Blade capsule sweeps and async traces still go through physics scene.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CollisionHandler")
+	uint32 bUseHurtboxNarrowphase : 1;
+
+	/**
+	 * Whether trace check should first look up HurtboxComponents near swept sockets in broadphase grid of CollisionHandlerSubsystem.
+	 * Trace check is skipped when no hurtbox is nearby, narrowphase tests only capsules of nearby hurtboxes.
+	 * Like bUseHurtboxNarrowphase it assumes that only actors with HurtboxComponent are worth hitting.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CollisionHandler")
+	uint32 bUseHurtboxBroadphase : 1;
+
+	/**
+	 * Whether path of socket between two trace checks should be rebuilt as an arc fitted to the last three socket samples instead of a straight line.
+	 * Allows to use much bigger TraceCheckInterval (e.g. 10-15 Hz on AI) without missing hits of fast weapon swings.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CollisionHandler")
+	uint32 bInterpolateSocketArc : 1;
+
+	/* Number of sweeps the rebuilt arc between two samples is split into, used only if bInterpolateSocketArc is set */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CollisionHandler", meta = (ClampMin = "1", EditCondition = "bInterpolateSocketArc"))
+	int32 ArcSubsteps;
+
+	/**
+	 * Whether time between trace checks should follow measured motion of sockets instead of fixed TraceCheckInterval.
+	 * Error of a sweep is the distance between swept straight path and the arc fitted to the last three samples. Interval grows while sockets
+	 * move slowly or straight (wind-up, recovery) and shrinks in fast curved strikes, arc of a step that exceeded the error anyway is split
+	 * into more sweeps. Uses arc interpolation regardless of bInterpolateSocketArc, TraceCheckInterval is the first interval of activation.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CollisionHandler|Adaptive")
+	uint32 bUseAdaptiveTraceInterval : 1;
+
+	/* Max distance in cm between path covered by sweeps and path of socket, used only if bUseAdaptiveTraceInterval is set */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CollisionHandler|Adaptive", meta = (ClampMin = "0.01", EditCondition = "bUseAdaptiveTraceInterval"))
+	float MaxTraceDistanceError;
+
+	/* Bounds of adaptive interval, max is also the longest time hits can be delayed by */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CollisionHandler|Adaptive", meta = (ClampMin = "0.0", EditCondition = "bUseAdaptiveTraceInterval"))
+	float MinTraceCheckInterval;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CollisionHandler|Adaptive", meta = (ClampMin = "0.0", EditCondition = "bUseAdaptiveTraceInterval"))
+	float MaxTraceCheckInterval;
+
+	/* Max number of sweeps the arc of single step is split into when its error is too big */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CollisionHandler|Adaptive", meta = (ClampMin = "1", EditCondition = "bUseAdaptiveTraceInterval"))
+	int32 MaxAdaptiveArcSubsteps;
+
+	/**
+	 * Whether socket locations should be rebuilt from trajectories baked into the montage that activated collision (see BakeSocketTrajectories)
+	 * and from mesh transform, instead of evaluated bone transforms. Allows servers to skip pose evaluation with VisibilityBasedAnimTickOption.
+	 * Sockets are matched by name with sockets of the mesh playing the montage, live pose is used if montage wasn't baked.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CollisionHandler")
+	uint32 bUseBakedTrajectories : 1;
+
+	/* Shape used to cover path of sockets, BladeCapsule needs at least two sockets ordered along the blade */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CollisionHandler")
+	ECollisionTraceShape TraceShape;
+
+	/**
+	 * Max angle in degrees blade can rotate within single capsule sweep, bigger rotations are split into more sweeps.
+	 * Capsule radius grows by half blade length times sine of half this angle, so smaller angle keeps sweeps thinner.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CollisionHandler", meta = (ClampMin = "1.0", ClampMax = "180.0"))
+	float MaxBladeSweepAngle;
+
 	/* Classes that will be ignored while checking collision */
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CollisionHandler")
 	TArray<TSubclassOf<AActor>> IgnoredClasses;
@@ -90,16 +378,90 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CollisionHandler")
 	TArray<TEnumAsByte<EObjectTypeQuery>> ObjectTypesToCollideWith;
 
+	/**
+	 * Distance around owner and colliding components in which IgnoredClasses and IgnoredCollisionProfileNames are resolved on activation.
+	 * Resolved actors and components are filtered by physics before sweeps, ones which come closer later are filtered after their first hit.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CollisionHandler", meta = (ClampMin = "0.0"))
+	float IgnoreRulesPrefilterReach;
+
+	/**
+	 * Whether fidelity of trace checks should follow significance of the handler, so distant and off-screen fights are cheaper.
+	 * Handlers of player controlled pawns and handlers near players always use the first tier.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CollisionHandler|Fidelity")
+	uint32 bUseFidelityTiers : 1;
+
+	/* Tiers ordered from full fidelity to the lowest one, the first tier whose MinSignificance is reached is used */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CollisionHandler|Fidelity", meta = (EditCondition = "bUseFidelityTiers"))
+	TArray<FCollisionFidelityTier> FidelityTiers;
+
+	/* Determines how significance is computed and how tier changes are damped */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CollisionHandler|Fidelity", meta = (EditCondition = "bUseFidelityTiers"))
+	FCollisionSignificanceSettings SignificanceSettings;
+
+	/* Determines whether and when actors already hit during activation can be hit again */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CollisionHandler")
+	FCollisionRehitSettings RehitSettings;
+
+	/**
+	 * Whether socket locations and owner hurtbox should be recorded in fixed size history, even while collision is not activated.
+	 * Sockets of every registered collision part are recorded, default part first, then parts in enum order.
+	 * Used by server to validate hits claimed by clients against state rewound to client time, see ValidateHitAtTime.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CollisionHandler|History")
+	uint32 bRecordHistory : 1;
+
+	/* How many seconds of history are kept, bounds memory used by history */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CollisionHandler|History", meta = (ClampMin = "0.0", EditCondition = "bRecordHistory"))
+	float HistoryDuration;
+
+	/* How often history sample is recorded */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CollisionHandler|History", meta = (ClampMin = "0.001", EditCondition = "bRecordHistory"))
+	float HistorySampleInterval;
+
+	/* Radius of owner hurtbox capsule, taken from owner capsule component at BeginPlay if root component is a capsule */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CollisionHandler|History", meta = (EditCondition = "bRecordHistory"))
+	float HurtboxRadius;
+
+	/* Half height of owner hurtbox capsule, taken from owner capsule component at BeginPlay if root component is a capsule */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CollisionHandler|History", meta = (EditCondition = "bRecordHistory"))
+	float HurtboxHalfHeight;
+
+	/* Extra distance accepted by ValidateHitAtTime, covers interpolation error of rewound state */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CollisionHandler|History", meta = (ClampMin = "0.0", EditCondition = "bRecordHistory"))
+	float ValidationTolerance;
+
+	/**
+	 * Whether every activation should be captured to trajectory file of CollisionHandlerSubsystem: socket locations of every trace check
+	 * and posed capsules of HurtboxComponents near sockets. Captured fights can be replayed offline by StarterBundleReplay commandlet.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CollisionHandler|Capture")
+	uint32 bCaptureTrajectory : 1;
+
+	/**
+	 * Whether hits should be collected during trace checks and delivered once per frame through OnHitBatch instead of OnHit per hit.
+	 * Keeps delegate calls and Blueprint VM out of the trace loop, e.g. cleave hitting 6 enemies makes 2 broadcasts instead of 12.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CollisionHandler")
+	uint32 bDispatchHitsInBatches : 1;
+
 	/* Determines debug mode: None/ForDuration/ForOneFrame etc. */
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CollisionHandler")
 	ECollisionHandlerDebugMode DebugMode;
 
-	/* Delegate called when there was a collision */
+	/* Delegate called when there was a collision, not called if bDispatchHitsInBatches is set */
 	UPROPERTY(BlueprintAssignable, Category = "CollisionHandler")
 	FOnHit OnHit;
 	/* Native version above, called before BP delegate */
 	FOnHitNative OnHitNative;
 
+	/* Delegate called once per frame with all hits of the frame, used instead of OnHit if bDispatchHitsInBatches is set */
+	UPROPERTY(BlueprintAssignable, Category = "CollisionHandler")
+	FOnHitBatch OnHitBatch;
+	/* Native version above, called before BP delegate. View is valid only during the call */
+	FOnHitBatchNative OnHitBatchNative;
+
 	/* Delegate called when collision was activated */
 	UPROPERTY(BlueprintAssignable, Category = "CollisionHandler")
 	FOnCollisionActivated OnCollisionActivated;
@@ -112,18 +474,54 @@ public:
 	/* Native version above, called before BP delegate */
 	FOnCollisionDeactivatedNative OnCollisionDeactivatedNative;
 
-	/* Updates colliding component and sockets array that should be associated with it */
+	/* Updates colliding component and sockets of default part, used by every activated part that wasn't registered with RegisterCollisionPart */
 	UFUNCTION(BlueprintCallable, Category = "CollisionHandler")
 	void UpdateCollidingComponentAndSockets(UPrimitiveComponent* Component, const TArray<FName>& Sockets);
 
-	/* Activates collision, usually called by anim notify (ActivateCollisionNotifyState) on anim montage */
+	/**
+	 * Registers colliding component and sockets of given part, usually once at BeginPlay or when weapon is equipped.
+	 * Activating the part then only marks it active, so parts can be switched without copying sockets. NONE sets default part.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "CollisionHandler")
+	void RegisterCollisionPart(ECollisionPart CollisionPart, UPrimitiveComponent* Component, const TArray<FName>& Sockets);
+
+	/* Removes part registered with RegisterCollisionPart, default part is used by it from now on */
+	UFUNCTION(BlueprintCallable, Category = "CollisionHandler")
+	void UnregisterCollisionPart(ECollisionPart CollisionPart);
+
+	/**
+	 * Activates collision of given part, usually called by anim notify (ActivateCollisionNotifyState) on anim montage.
+	 * Several parts can be active at once, e.g. by overlapping notify windows. They are traced in one pass and share actors hit during activation,
+	 * which lasts until the last active part is deactivated.
+	 */
 	UFUNCTION(BlueprintCallable, Category = "CollisionHandler")
 	void ActivateCollision(ECollisionPart CollisionPart);
 
-	/* Deactivates collision, usually called by anim notify (ActivateCollisionNotifyState) on anim montage */
+	/* Deactivates collision of all parts */
 	UFUNCTION(BlueprintCallable, Category = "CollisionHandler")
 	void DeactivateCollision();
 
+	/**
+	 * Deactivates collision of given part, usually called by anim notify (ActivateCollisionNotifyState) on anim montage.
+	 * Part activated several times, e.g. by overlapping notify windows on the same part, stays active until deactivated as many times.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "CollisionHandler")
+	void DeactivateCollisionPart(ECollisionPart CollisionPart);
+
+	/* Sets expected length of next activation in world time, used to place midpoint overlap of the lowest fidelity tier. Called by ActivateCollisionNotifyState */
+	void SetActivationDuration(float Duration);
+
+	/* Returns index of fidelity tier in FidelityTiers currently used, 0 if tiers aren't used */
+	UFUNCTION(BlueprintCallable, Category = "CollisionHandler|Fidelity")
+	int32 GetFidelityTier() const;
+
+	/* Returns last computed significance, 1 if tiers aren't used */
+	UFUNCTION(BlueprintCallable, Category = "CollisionHandler|Fidelity")
+	float GetSignificance() const;
+
+	/* Sets mesh and animation that baked trajectories of next activation are read from, called by ActivateCollisionNotifyState before ActivateCollision */
+	void SetTrajectorySource(USkeletalMeshComponent* Mesh, UAnimSequenceBase* Animation);
+
 	UFUNCTION(BlueprintCallable, Category = "CollisionHandler")
 	TArray<FName> GetCollisionSockets() const;
 
@@ -136,19 +534,84 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "CollisionHandler")
 	ECollisionPart GetActivatedCollisionPart() const;
 
+	UFUNCTION(BlueprintCallable, Category = "CollisionHandler")
+	bool IsCollisionPartActivated(ECollisionPart CollisionPart) const;
+
+	/**
+	 * Checks whether sockets of this handler could have hit hurtbox of Target at given time, both rewound using recorded history.
+	 * Sweeps every recorded socket of all registered parts over last HistorySampleInterval before ClientTime against Target hurtbox capsule. Doesn't allocate memory.
+	 * ClientTime is in server world time, e.g. taken from GameState::GetServerWorldTimeSeconds on client.
+	 * Both handlers need bRecordHistory set, returns false if time is older than recorded history.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "CollisionHandler|History")
+	bool ValidateHitAtTime(const UCollisionHandlerComponent* Target, float ClientTime) const;
+
+	/* Returns number of bytes used by recorded history */
+	UFUNCTION(BlueprintCallable, Category = "CollisionHandler|History")
+	int32 GetHistoryMemoryBytes() const;
+
+	/* Records history sample, history is recorded only in tick */
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+	/* Delivers hits collected since last dispatch through OnHitBatch delegates, called by CollisionHandlerSubsystem at the end of frame */
+	void DispatchPendingHits();
+
+	/* Returns number of sweeps issued since component was created, used by benchmarks */
+	int64 GetNumSweepsIssued() const;
+
+	/**
+	 * Returns location on arc going through three samples, Alpha 0 is LastLocation and 1 is CurrentLocation.
+	 * PreviousIntervalRatio is time between second last and last sample divided by time between last and current one.
+	 */
+	static FVector InterpolateSocketArc(const FVector& SecondLastLocation, const FVector& LastLocation, const FVector& CurrentLocation, float Alpha, float PreviousIntervalRatio = 1.f);
+
+	/**
+	 * Returns significance handler has to get past to move from CurrentTier to the next higher (bIsRaising) or lower tier.
+	 * Hysteresis is limited to half of the gap between thresholds of neighbouring tiers and threshold to 1, so every tier stays reachable.
+	 */
+	static float GetFidelityTierChangeThreshold(const TArray<FCollisionFidelityTier>& Tiers, int32 CurrentTier, bool bIsRaising, float Hysteresis);
+
+	/* Returns interval of next trace check, changes with socket motion if bUseAdaptiveTraceInterval is set and with fidelity tier */
+	float GetCurrentTraceCheckInterval() const;
+
+	/* Returns collision handler of given actor without scanning its components, nullptr if actor has no registered handler */
+	static UCollisionHandlerComponent* FindCollisionHandler(const AActor* Actor);
+
+	/**
+	 * Advances trace check by given time, called every frame by CollisionHandlerSubsystem while collision is activated.
+	 * With bDeferSweeps set, sync sweeps of trace check are left for PerformDeferredSweeps and MergeDeferredSweeps.
+	 */
+	void TickBatchedTraceCheck(float DeltaTime, bool bDeferSweeps = false);
+
+	/* Whether last trace check left sweeps for PerformDeferredSweeps */
+	bool HasDeferredSweeps() const { return bHasDeferredSweeps; }
+
+	/* Sweeps deferred segments and keeps their hits, doesn't touch anything outside of this handler so handlers can be swept on worker threads */
+	void PerformDeferredSweeps();
+
+	/* Processes hits of deferred sweeps in order of segments, called on game thread after all deferred sweeps are done */
+	void MergeDeferredSweeps();
+
 protected:
 	/* Called when the game starts */
 	virtual void BeginPlay() override;
 
-	/* Tracks which collision part was recently activated */
+	/* Called when the game ends or component is destroyed */
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	/* Adds and removes component from lookup used by FindCollisionHandler */
+	virtual void OnRegister() override;
+	virtual void OnUnregister() override;
+
+	/* Tracks which collision part was recently activated, NONE if no part is activated */
 	UPROPERTY(BlueprintReadOnly, Category = "CollisionHandler")
 	ECollisionPart ActivatedCollisionPart;
 
-	/* Component from which socket locations will be taken, may be Static Mesh sword, Character Mesh etc. */
+	/* Component of default part from which socket locations will be taken, may be Static Mesh sword, Character Mesh etc. */
 	UPROPERTY(BlueprintReadOnly, Category = "CollisionHandler")
 	UPrimitiveComponent* CollidingComponent;
 
-	/* Array of sockets which locations will be taken from CollidinMesh to check for collision */
+	/* Array of sockets of default part which locations will be taken from CollidinMesh to check for collision */
 	UPROPERTY(BlueprintReadOnly, Category = "CollsionHandler")
 	TArray<FName> CollisionSockets;
 
@@ -161,23 +624,161 @@ protected:
 	void NotifyOnCollisionActivated(ECollisionPart CollisionPart);
 	void NotifyOnCollisionDeactivated();
 
-	/* Updates values in map LastFrameSocketLocations */
-	void UpdateSocketLocations();
+	/* Resolves sockets of colliding component of given part to bone indices and offsets */
+	static void ResolveSocketBindings(FCollisionPartState& Part);
+
+	/* Returns mesh asset of colliding component of given part that socket bindings depend on */
+	static UObject* GetCollidingMeshAsset(const FCollisionPartState& Part);
+
+	/* Computes current locations of all sockets of given part and stores them in its CurrentSocketLocations */
+	void SampleSocketLocations(FCollisionPartState& Part);
 
-	/* Does a sphere trace between socket locations in last and current frame and check whether 
+	/* Computes current locations of sockets from baked trajectories, returns false if they don't cover current montage position or sockets */
+	bool SampleBakedSocketLocations(FCollisionPartState& Part);
+
+	/* Moves current socket locations to LastSocketLocations and keeps older ones if needed */
+	void UpdateSocketLocations(FCollisionPartState& Part);
+
+	/* Does a sphere trace along SweepSegments gathered from all active parts and check whether 
 	there is any colliding object between these locations */
 	void PerformTraceCheck();
+
+	/* Appends to SweepSegments sweeps between socket locations of given part in last and current frame, arc is split into given number of sweeps */
+	void GatherSweepSegments(const FCollisionPartState& Part, int32 NumArcSubsteps);
+
+	/* Appends to SweepSegments capsule sweeps covering blade going from first to last socket of given part */
+	void GatherBladeSweepSegments(const FCollisionPartState& Part, int32 NumArcSubsteps);
+
+	/* Returns max distance between straight sweeps and arcs fitted to sockets of given part, part needs second last locations */
+	float EstimateArcError(const FCollisionPartState& Part) const;
+
+	/* Picks interval of next trace check from arc error of last step, negative error means there was no estimate */
+	void UpdateAdaptiveTraceInterval(float ArcError, float StepInterval);
+
+	/* Returns significance of handler computed from locations of players */
+	float ComputeSignificance() const;
+
+	/* Computes significance if it is time to and changes fidelity tier if significance got far enough past tier thresholds */
+	void UpdateFidelityTier(bool bIgnoreUpdateInterval);
+
+	/* Returns fidelity tier currently used, nullptr if tiers aren't used */
+	const FCollisionFidelityTier* GetActiveFidelityTier() const;
+
+	/* Returns multiplier of trace check interval of used fidelity tier */
+	float GetFidelityIntervalScale() const;
+
+	/* Sets CurrentTraceCheckInterval to the first interval of activation or fidelity tier and reschedules running timer */
+	void ResetTraceCheckInterval();
+
+	/* Overlaps blade or sphere of sockets of all active parts and processes overlapped components as hits */
+	void PerformMidpointOverlap();
+
+	/* Sweeps given segment against hurtboxes or the world according to bUseHurtboxNarrowphase, doesn't draw or record it */
+	bool PerformSweep(const FCollisionSweepSegment& Segment, TArray<FHitResult>& OutHitResults);
+
+	/* Sweeps sphere or capsule of given segment against the world */
+	bool SweepSegment(const FCollisionSweepSegment& Segment, const FCollisionQueryParams& QueryParams, TArray<FHitResult>& OutHitResults);
+
+	/* Returns shape swept along given segment */
+	FCollisionShape MakeSweepShape(const FCollisionSweepSegment& Segment) const;
+
+	/* Fills HurtboxCandidates with hurtboxes overlapping bounds of SweepSegments, returns false if trace check can be skipped */
+	bool GatherHurtboxCandidates();
+
+	/* Sweeps sphere segment against hurtbox capsules registered in CollisionHandlerSubsystem, returns whether anything was hit */
+	bool SweepHurtboxes(const FCollisionSweepSegment& Segment, TArray<FHitResult>& OutHitResults);
+
+	/* Draws or records swept segment and its hits according to DebugMode */
+	void DebugSweep(const FCollisionSweepSegment& Segment, bool bWasHit, const TArray<FHitResult>& HitResults) const;
+
+	/* Stores sweep in trace recorder of CollisionHandlerSubsystem */
+	void RecordSweep(const FVector& Start, const FVector& End, float Radius, float HalfHeight, bool bWasHit) const;
+
+	/* Returns query params of sweeps, ignored actors and components are rejected by physics query filter */
+	FCollisionQueryParams MakeQueryParams() const;
+
+	/* Issues async sphere sweeps for SweepSegments, results are handled in OnAsyncTraceCompleted */
+	void PerformAsyncTraceCheck();
+
+	/* Filters hit results and calls OnHit for every actor that can be hit according to RehitSettings */
+	void ProcessHitResults(const TArray<FHitResult>& HitResults);
 private:	
-	/* Array storing temporary actors that were hit during single activation */
+	/* Registry of actors that were hit during single activation */
+	FCollisionHitRegistry HitRegistry;
+
+	/* Actors ignored by traces during single activation, owner, actors of ignored classes and actors that can't be hit again */
 	UPROPERTY()
-	TArray<AActor*> HitActors;
+	TArray<AActor*> IgnoredActors;
 
-	/* Map storing location of socket in last frame */
+	/* Components with ignored profile names found during single activation, ignored by following traces */
 	UPROPERTY()
-	TMap<FName, FVector> LastFrameSocketLocations;
+	TArray<UPrimitiveComponent*> IgnoredComponents;
+
+	/* Query params built once per activation from IgnoredActors and IgnoredComponents, kept in sync by IgnoreActor and IgnoreComponent */
+	FCollisionQueryParams ActivationQueryParams;
+
+	/* Object query params built once per activation from ObjectTypesToCollideWith */
+	FCollisionObjectQueryParams ActivationObjectQueryParams;
+
+	/* Adds actor or component to ignore lists and to ActivationQueryParams */
+	void IgnoreActor(AActor* Actor);
+	void IgnoreComponent(UPrimitiveComponent* Component);
+
+	/* Hits of single sweep, reused between sweeps so steady state trace loop doesn't allocate */
+	TArray<FHitResult> ScratchHitResults;
+	TArray<FHurtboxCapsuleHit> ScratchCapsuleHits;
+
+	/* Hits of all deferred sweeps in order of SweepSegments and number of hits of every segment */
+	TArray<FHitResult> DeferredHitResults;
+	TArray<int32> DeferredHitCounts;
+
+	/* Whether sweeps of current trace check are deferred by CollisionHandlerSubsystem, and whether SweepSegments wait for them */
+	uint32 bShouldDeferSweeps : 1;
+	uint32 bHasDeferredSweeps : 1;
+
+	/* Cached answers of IsIgnoredClass, valid as long as IgnoredClasses are equal to CompiledIgnoredClasses */
+	TMap<FObjectKey, bool> IgnoredClassCache;
 
-	/* Determines whether trace check can be performed, used to make sure it wont happen on first timer tick to firstly store socket locations */
-	uint32 bCanPerformTrace : 1;
+	/* Copy of IgnoredClasses that IgnoredClassCache was built for */
+	TArray<TSubclassOf<AActor>> CompiledIgnoredClasses;
+
+	/* Hashed copy of IgnoredCollisionProfileNames */
+	TSet<FName> IgnoredProfileNameSet;
+
+	/* Prepares ignore rules for new activation */
+	void CompileIgnoreRules();
+
+	/* Adds actors and components within IgnoreRulesPrefilterReach matching ignore rules to ActivationQueryParams, so sweeps don't return them */
+	void PrefilterIgnoreRules();
+
+	/* Registered parts indexed by ECollisionPart, entry of NONE is default part used by parts which weren't registered */
+	UPROPERTY(Transient)
+	TArray<FCollisionPartState> CollisionParts;
+
+	/* Bit per activated ECollisionPart */
+	uint32 ActivePartMask;
+
+	/* Number of ActivateCollision calls not yet matched by DeactivateCollisionPart, indexed by ECollisionPart */
+	TArray<uint16> PartActivationCounts;
+
+	/* Bit per entry of CollisionParts traced by activated parts, parts which weren't registered share default entry */
+	uint32 ActiveStateMask;
+
+	/* Mesh and animation passed to SetTrajectorySource, moved to part state by next activation */
+	TWeakObjectPtr<USkeletalMeshComponent> PendingTrajectorySourceMesh;
+	TWeakObjectPtr<UAnimSequenceBase> PendingTrajectorySourceAnimation;
+
+	/* Returns index of entry of CollisionParts used by given part */
+	int32 GetPartStateIndex(ECollisionPart CollisionPart) const;
+
+	/* Rebuilds ActiveStateMask from ActivePartMask */
+	void UpdateActiveStates();
+
+	/* Sweeps of current trace check, kept as member to reuse its memory */
+	TArray<FCollisionSweepSegment> SweepSegments;
+
+	/* Owner indices of hurtboxes near SweepSegments, reused between trace checks */
+	TArray<int32> HurtboxCandidates;
 
 	/* Checks whether given class should be ignored or not */
 	bool IsIgnoredClass(TSubclassOf<AActor> ActorClass);
@@ -185,10 +786,134 @@ private:
 	/* Checks whether given profile name is ignored or not*/
 	bool IsIgnoredProfileName(FName ProfileName);
 
+	/* Delegate bound to OnAsyncTraceCompleted, passed to every async sweep */
+	FTraceDelegate AsyncTraceDelegate;
+
+	/* Incremented on every activation, used to discard async results of previous activations */
+	uint32 ActivationId;
+
+	/* Ring buffer of socket locations and owner hurtbox transforms, used for hit validation */
+	FCollisionHistoryBuffer History;
+
+	/* Socket locations of all registered parts gathered for one history sample, kept to avoid allocating every sample */
+	TArray<FVector> HistorySocketLocations;
+
+	/* Returns number of sockets over all registered parts, which is number of sockets recorded in history */
+	int32 GetNumHistorySockets() const;
+
+	/* Allocates history for sockets of all registered parts, called at BeginPlay and when parts are registered */
+	void InitializeHistory();
+
+	/* Samples sockets and owner hurtbox and stores them in history */
+	void RecordHistorySample();
+
+	/* Number of sweeps issued since component was created */
+	int64 NumSweepsIssued;
+
+	/* Called by the world when async sweep is completed */
+	void OnAsyncTraceCompleted(const FTraceHandle& TraceHandle, FTraceDatum& TraceDatum);
+
 	/* function called on timer to perform trace check */
 	UFUNCTION()
 	void TraceCheckLoop();
 
+	/* function called when bones of PoseSourceMesh are finalized to perform trace check */
+	UFUNCTION()
+	void OnPoseUpdated();
+
+	/* Returns skeletal mesh whose pose moves colliding component of the first active part, nullptr if there is none */
+	USkeletalMeshComponent* FindPoseSourceMesh() const;
+
+	/* Moves running trace check loop to pose updates of mesh returned by FindPoseSourceMesh, called when active parts change */
+	void UpdatePoseSource();
+
+	/**
+	 * Returns world transform of component as it will be once children of PoseSourceMesh follow its new pose.
+	 * OnBoneTransformsFinalized is broadcast before the mesh updates its children, so their own transforms are one pose behind.
+	 */
+	FTransform GetPoseComponentTransform(const USceneComponent* Component) const;
+
+	/* Adds given time to TraceCheckTimeAccumulator and performs at most one trace check if interval has passed */
+	void AdvanceTraceCheck(float DeltaTime);
+
+	/* Samples socket locations and performs trace check against previous sample */
+	void TraceCheckStep();
+
 	/* Handle for trace check loop timer */
 	FTimerHandle TraceCheckTimerHandle;
+
+	/* Time accumulated since last batched or pose driven trace check */
+	float TraceCheckTimeAccumulator;
+
+	/* Mesh whose pose updates drive trace checks while bSampleOnPoseUpdate is used */
+	UPROPERTY(Transient)
+	USkeletalMeshComponent* PoseSourceMesh;
+
+	/* World time and frame of last pose update of PoseSourceMesh */
+	float LastPoseUpdateTime;
+	uint64 LastPoseUpdateFrame;
+
+	/* Interval used by trace check loop, TraceCheckInterval unless bUseAdaptiveTraceInterval is set */
+	float CurrentTraceCheckInterval;
+
+	/* World time of last trace check, negative before first one of activation, and time between last two trace checks */
+	float LastTraceCheckTime;
+	float LastStepInterval;
+
+	/* Time between second last and last sample divided by time between last and current one, used to fit arcs of current step */
+	float ArcIntervalRatio;
+
+	/* Index of used fidelity tier, last significance, time of last tier change and time of next significance update */
+	int32 FidelityTierIndex;
+	float Significance;
+	float FidelityTierChangeTime;
+	float NextSignificanceUpdateTime;
+
+	/* World time when collision was activated, expected length of activation (0 if unknown) and length passed to SetActivationDuration */
+	float ActivationStartTime;
+	float ActivationDuration;
+	float PendingActivationDuration;
+
+	/* Whether midpoint overlap of the lowest fidelity tier was done during this activation */
+	uint32 bHasDoneMidpointOverlap : 1;
+
+	/* Overlaps of midpoint overlap, kept as member to reuse its memory */
+	TArray<FOverlapResult> ScratchOverlaps;
+
+	/* Whether trace checks are currently driven by CollisionHandlerSubsystem instead of timer */
+	uint32 bIsRegisteredInSubsystem : 1;
+
+	/* Whether trace check loop is running, whichever drives it, counted by STAT_ActiveCollisionHandlers */
+	uint32 bIsTraceCheckLoopRunning : 1;
+
+	/* Whether activation is currently written to trajectory file */
+	uint32 bIsCapturingActivation : 1;
+
+	/* Owner indices of hurtboxes near sockets of captured sample, reused between samples */
+	TArray<int32> CaptureTargets;
+
+	/* Current socket locations of all active parts in order of CollisionParts, and bounds of their current and last locations */
+	TArray<FVector> CaptureSocketLocations;
+	FBox CaptureSocketBounds;
+
+	/* Starts, writes sample of and ends captured activation */
+	void BeginTrajectoryCapture();
+	void CaptureTrajectorySample();
+	void EndTrajectoryCapture();
+
+	/* Hits waiting for DispatchPendingHits */
+	TArray<FHitResult> PendingHits;
+
+	/* Hits being broadcast by DispatchPendingHits, kept apart so callbacks can't modify them */
+	TArray<FHitResult> DispatchingHits;
+
+	/* Whether handler is queued for DispatchPendingHits in CollisionHandlerSubsystem */
+	uint32 bIsHitDispatchQueued : 1;
+
+	/* Stores hit for batched dispatch and queues handler in subsystem, dispatches right away if subsystem is not available */
+	void QueueHitForDispatch(const FHitResult& HitResult);
+
+	/* Starts and stops trace check loop, either batched in subsystem or on timer */
+	void StartTraceCheckLoop();
+	void StopTraceCheckLoop();
 };
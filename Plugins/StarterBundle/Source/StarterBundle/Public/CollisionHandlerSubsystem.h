@@ -0,0 +1,172 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "HurtboxCapsuleSet.h"
+#include "HurtboxBroadphaseGrid.h"
+#include "CollisionTraceRecorder.h"
+#include "CollisionTrajectoryCapture.h"
+#include "CollisionHandlerSubsystem.generated.h"
+
+class UCollisionHandlerComponent;
+class UHurtboxComponent;
+
+/**
+ * World subsystem which owns the list of collision handlers with activated collision
+ * and performs their socket updates and trace checks in one contiguous pass per frame.
+ * Used instead of per-component looping timers when UCollisionHandlerComponent::bUseBatchedTraceCheck is set.
+ * Also owns world space hurtbox capsules of all HurtboxComponents, tested by handlers with bUseHurtboxNarrowphase set,
+ * and uniform grid of their bounds used by handlers with bUseHurtboxBroadphase set.
+ * Keeps trace records of handlers with ECollisionHandlerDebugMode::Record and trajectory file of handlers with bCaptureTrajectory set.
+ * Sync sweeps of the pass can be spread over worker threads with SetNumParallelTraceWorkers, hits are still processed on game thread in order of handlers.
+ */
+UCLASS()
+class STARTERBUNDLE_API UCollisionHandlerSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	/* overridden USubsystem functions */
+	virtual void Deinitialize() override;
+
+	/* overridden FTickableGameObject functions */
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual TStatId GetStatId() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override;
+
+	/* Adds handler to the batched pass, does nothing if it is already registered */
+	void RegisterHandler(UCollisionHandlerComponent* Handler);
+
+	/* Removes handler from the batched pass, safe to call during the pass (e.g. from OnHit callback) */
+	void UnregisterHandler(UCollisionHandlerComponent* Handler);
+
+	/* Returns number of handlers currently processed by the batched pass */
+	UFUNCTION(BlueprintCallable, Category = "CollisionHandler")
+	int32 GetNumActiveHandlers() const;
+
+	/**
+	 * Sets max number of threads sweeping handlers of the pass at once, game thread included.
+	 * 0 sweeps every handler right after its trace check, 1 and more defers sweeps of all handlers and runs them together.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "CollisionHandler")
+	void SetNumParallelTraceWorkers(int32 NumWorkers);
+
+	/* Queues handler for DispatchPendingHits at the end of this frame's pass */
+	void QueueHitDispatch(UCollisionHandlerComponent* Handler);
+
+	/* Returns recorder of traces of handlers with ECollisionHandlerDebugMode::Record */
+	FCollisionTraceRecorder& GetTraceRecorder() { return TraceRecorder; }
+
+	/* Sets max number of kept trace records, forgets recorded ones */
+	UFUNCTION(BlueprintCallable, Category = "CollisionHandler")
+	void SetTraceRecorderCapacity(int32 Capacity);
+
+	/* Writes trace records to binary file, to Saved/CollisionTraces if Filename is empty. Also available as StarterBundle.DumpTraceRecords */
+	UFUNCTION(BlueprintCallable, Category = "CollisionHandler")
+	bool DumpTraceRecords(const FString& Filename);
+
+	/* Returns writer of trajectories of handlers with bCaptureTrajectory set */
+	FCollisionTrajectoryWriter& GetTrajectoryWriter() { return TrajectoryWriter; }
+
+	/* Opens trajectory file in Saved/CollisionTrajectories if it isn't open yet, returns whether it is open */
+	bool OpenTrajectoryCapture();
+
+	/* Closes trajectory file, next captured activation opens new one */
+	UFUNCTION(BlueprintCallable, Category = "CollisionHandler")
+	void CloseTrajectoryCapture();
+
+	/* Adds hurtbox to capsules tested by hurtbox narrowphase */
+	void RegisterHurtbox(UHurtboxComponent* Hurtbox);
+
+	/* Removes hurtbox from capsules tested by hurtbox narrowphase */
+	void UnregisterHurtbox(UHurtboxComponent* Hurtbox);
+
+	/* Returns world space capsules of all registered hurtboxes, posed at most once per frame on first request */
+	const FHurtboxCapsuleSet& GetHurtboxCapsules();
+
+	/* Returns hurtbox which added capsule with given owner index */
+	UHurtboxComponent* GetHurtbox(int32 OwnerIndex) const;
+
+	/* Appends owner indices of hurtboxes whose bounds overlap given bounds */
+	void QueryHurtboxes(const FBox& Bounds, TArray<int32>& OutOwnerIndices);
+
+	/* Returns range of capsules in GetHurtboxCapsules added by hurtbox with given owner index */
+	void GetHurtboxCapsuleRange(int32 OwnerIndex, int32& OutFirstCapsule, int32& OutNumCapsules) const;
+
+	/* Sets edge length of broadphase grid cells, should be about the size of a combatant */
+	UFUNCTION(BlueprintCallable, Category = "CollisionHandler")
+	void SetHurtboxCellSize(float NewCellSize);
+
+	/* Returns locations of pawns of all players, or their view points if they have no pawn, gathered at most once per frame on first request */
+	const TArray<FVector>& GetPlayerLocations();
+
+private:
+	/* Handlers with activated collision, processed in order of registration */
+	UPROPERTY()
+	TArray<UCollisionHandlerComponent*> ActiveHandlers;
+
+	/* Whether handlers are currently being processed, removals are deferred until the pass ends */
+	uint32 bIsProcessingHandlers : 1;
+
+	/* Whether any handler was unregistered during the pass and its slot has to be compacted */
+	uint32 bHasPendingRemovals : 1;
+
+	/* Handlers with hits waiting for batched dispatch */
+	UPROPERTY()
+	TArray<UCollisionHandlerComponent*> HandlersWithPendingHits;
+
+	/* Handlers being dispatched, hits queued by their callbacks go to HandlersWithPendingHits and are dispatched next frame */
+	UPROPERTY()
+	TArray<UCollisionHandlerComponent*> DispatchingHandlers;
+
+	/* Dispatches pending hits of all queued handlers */
+	void DispatchPendingHits();
+
+	/* Max number of threads sweeping handlers at once, 0 means sweeps aren't deferred */
+	int32 NumParallelTraceWorkers;
+
+	/* Handlers of this pass whose sweeps were deferred, in order of ActiveHandlers */
+	UPROPERTY()
+	TArray<UCollisionHandlerComponent*> DeferredSweepHandlers;
+
+	/* Sweeps deferred handlers on worker threads and merges their hits on game thread */
+	void PerformDeferredSweeps();
+
+	/* Trace records of all handlers in this world */
+	FCollisionTraceRecorder TraceRecorder;
+
+	/* Streaming file of captured trajectories of all handlers in this world */
+	FCollisionTrajectoryWriter TrajectoryWriter;
+
+	/* Registered hurtboxes, index in this array is owner index of their capsules */
+	UPROPERTY()
+	TArray<UHurtboxComponent*> Hurtboxes;
+
+	/* World space capsules of Hurtboxes */
+	FHurtboxCapsuleSet HurtboxCapsules;
+
+	/* Range of HurtboxCapsules and their bounds per hurtbox, indexed by owner index */
+	TArray<int32> HurtboxFirstCapsules;
+	TArray<int32> HurtboxNumCapsules;
+	TArray<FBox> HurtboxBounds;
+
+	/* Broadphase grid of HurtboxBounds */
+	FHurtboxBroadphaseGrid HurtboxGrid;
+
+	/* Edge length of HurtboxGrid cells, 0 means default */
+	float HurtboxCellSize;
+
+	/* Frame in which HurtboxCapsules were posed, MAX_uint64 if they have to be rebuilt */
+	uint64 HurtboxCapsulesFrame;
+
+	/* Poses capsules of all hurtboxes and rebuilds broadphase grid, at most once per frame */
+	void UpdateHurtboxes();
+
+	/* Locations returned by GetPlayerLocations and frame in which they were gathered */
+	TArray<FVector> PlayerLocations;
+	uint64 PlayerLocationsFrame;
+};
@@ -0,0 +1,71 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Fixed size ring buffer of timestamped socket locations and hurtbox transforms of single collision handler.
+ * Memory is allocated once in Initialize, recording and reading samples never allocates.
+ * Used by server to rewind attacker sockets and target hurtboxes to the time a client claimed a hit.
+ */
+class STARTERBUNDLE_API FCollisionHistoryBuffer
+{
+public:
+	FCollisionHistoryBuffer();
+
+	/* Allocates memory for given number of samples with given number of sockets each, forgets all samples */
+	void Initialize(int32 InNumSockets, int32 InCapacity);
+
+	/* Forgets all samples, keeps allocated memory */
+	void Reset();
+
+	/* Stores new sample, overwrites the oldest one if buffer is full. Socket count must match Initialize */
+	void Record(float Time, const TArray<FVector>& InSocketLocations, const FTransform& HurtboxTransform);
+
+	/**
+	 * Finds two samples surrounding given time and blend weight between them.
+	 * Times newer than the newest sample are clamped to it, returns false if time is older than the oldest sample.
+	 */
+	bool FindSamples(float Time, int32& OutOlderSample, int32& OutNewerSample, float& OutAlpha) const;
+
+	/* Returns socket location blended between two samples found by FindSamples */
+	FVector GetSocketLocation(int32 OlderSample, int32 NewerSample, float Alpha, int32 SocketIndex) const;
+
+	/* Returns hurtbox transform blended between two samples found by FindSamples */
+	FTransform GetHurtboxTransform(int32 OlderSample, int32 NewerSample, float Alpha) const;
+
+	/* Returns number of recorded samples */
+	int32 Num() const { return NumSamples; }
+
+	/* Returns max number of samples */
+	int32 GetCapacity() const { return Capacity; }
+
+	/* Returns number of sockets stored in every sample */
+	int32 GetNumSockets() const { return NumSockets; }
+
+	/* Returns number of bytes allocated by buffer */
+	SIZE_T GetAllocatedSize() const;
+
+private:
+	/* Returns index in storage of sample, 0 is the oldest sample */
+	int32 GetStorageIndex(int32 Sample) const;
+
+	/* Time of every sample */
+	TArray<float> SampleTimes;
+
+	/* Socket locations of every sample, NumSockets per sample */
+	TArray<FVector> SocketLocations;
+
+	/* Hurtbox transform of every sample */
+	TArray<FTransform> HurtboxTransforms;
+
+	int32 NumSockets;
+	int32 Capacity;
+
+	/* Storage index that next sample will be written to */
+	int32 Head;
+
+	/* Number of recorded samples, up to Capacity */
+	int32 NumSamples;
+};
@@ -0,0 +1,86 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/ObjectKey.h"
+#include "CollisionHitRegistry.generated.h"
+
+/**
+ * Determines when actor that was already hit during activation can be hit again.
+ * OncePerActivation - actor is hit only once, it is also ignored by following traces
+ * RehitAfterCooldown - actor can be hit again after RehitCooldown seconds, e.g. spinning blades
+ * MaxHitsPerWindow - actor can be hit up to MaxHitsPerWindow times within every HitWindowDuration seconds
+ */
+UENUM(BlueprintType)
+enum class ECollisionRehitPolicy : uint8
+{
+	OncePerActivation,
+	RehitAfterCooldown,
+	MaxHitsPerWindow
+};
+
+/* Settings of re-hit policy used by collision handler */
+USTRUCT(BlueprintType)
+struct STARTERBUNDLE_API FCollisionRehitSettings
+{
+	GENERATED_BODY()
+
+	FCollisionRehitSettings()
+		: Policy(ECollisionRehitPolicy::OncePerActivation), RehitCooldown(0.5f), MaxHitsPerWindow(3), HitWindowDuration(1.f) {}
+
+	/* Determines when already hit actor can be hit again */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CollisionHandler")
+	ECollisionRehitPolicy Policy;
+
+	/* Time in seconds after which the same actor can be hit again, used by RehitAfterCooldown */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CollisionHandler", meta = (ClampMin = "0.0"))
+	float RehitCooldown;
+
+	/* Max number of hits of the same actor within window, used by MaxHitsPerWindow */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CollisionHandler", meta = (ClampMin = "1"))
+	int32 MaxHitsPerWindow;
+
+	/* Length of window in seconds, used by MaxHitsPerWindow */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CollisionHandler", meta = (ClampMin = "0.0"))
+	float HitWindowDuration;
+};
+
+/**
+ * Registry of actors hit during single collision activation.
+ * Lookups are hashed by actor, so cost doesn't grow with number of hits or length of activation.
+ */
+struct STARTERBUNDLE_API FCollisionHitRegistry
+{
+public:
+	/* Forgets all hits, keeps allocated memory for the next activation */
+	void Reset();
+
+	/**
+	 * Registers hit of given actor at given time if settings allow it, returns false if hit should be dropped.
+	 * The same actor is never hit twice at the same time, so hits from several sweeps of one trace check are merged.
+	 */
+	bool TryRegisterHit(const AActor* Actor, float Time, const FCollisionRehitSettings& Settings);
+
+	/* Returns whether given actor was hit during current activation */
+	bool WasHit(const AActor* Actor) const;
+
+	/* Returns number of different actors hit during current activation */
+	int32 Num() const;
+
+private:
+	struct FHitRecord
+	{
+		/* Time of the most recent hit */
+		float LastHitTime;
+
+		/* Time when current window of MaxHitsPerWindow started */
+		float WindowStartTime;
+
+		/* Hits within current window */
+		int32 WindowHitCount;
+	};
+
+	/* Hit records keyed by actor */
+	TMap<FObjectKey, FHitRecord> Records;
+};
@@ -0,0 +1,78 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/* Compact record of single collision handler sweep */
+struct FCollisionTraceRecord
+{
+	FVector Start;
+	FVector End;
+
+	/* Radius of swept sphere or capsule */
+	float Radius;
+
+	/* Half height of swept capsule, 0 for spheres */
+	float HalfHeight;
+
+	/* Value of GFrameCounter when sweep was done */
+	uint32 Frame;
+
+	/* Unique id of collision handler which did the sweep */
+	uint32 HandlerId;
+
+	/* Whether sweep returned any hit result */
+	bool bHit;
+
+	friend FArchive& operator<<(FArchive& Ar, FCollisionTraceRecord& Record);
+};
+
+/**
+ * Fixed size ring buffer of trace records of all collision handlers in one world, owned by CollisionHandlerSubsystem.
+ * Recording is a copy into preallocated memory, so it can stay enabled on live (also headless) servers.
+ * Records can be mirrored to Visual Logger while it is recording and dumped to binary file with StarterBundle.DumpTraceRecords.
+ */
+class STARTERBUNDLE_API FCollisionTraceRecorder
+{
+public:
+	FCollisionTraceRecorder();
+
+	/* Sets max number of records, forgets all records. Memory is allocated on first Record */
+	void SetCapacity(int32 InCapacity);
+
+	/* Forgets all records, keeps allocated memory */
+	void Reset();
+
+	/* Stores record, overwrites the oldest one if buffer is full. Also logs it to Visual Logger under VisLogOwner if it's recording */
+	void Record(const FCollisionTraceRecord& TraceRecord, const UObject* VisLogOwner);
+
+	/* Returns number of stored records */
+	int32 Num() const { return NumRecords; }
+
+	/* Returns max number of records */
+	int32 GetCapacity() const { return Capacity; }
+
+	/* Returns stored record, 0 is the oldest one */
+	const FCollisionTraceRecord& Get(int32 Index) const;
+
+	/* Writes all records from the oldest one to binary file, returns false if file couldn't be written */
+	bool SaveToFile(const FString& Filename) const;
+
+	/* Reads records written by SaveToFile, returns false if file is missing or has unknown format */
+	static bool LoadFromFile(const FString& Filename, TArray<FCollisionTraceRecord>& OutRecords);
+
+	/* Returns number of bytes allocated by recorder */
+	SIZE_T GetAllocatedSize() const;
+
+private:
+	TArray<FCollisionTraceRecord> Records;
+
+	int32 Capacity;
+
+	/* Index that next record will be written to */
+	int32 Head;
+
+	/* Number of stored records, up to Capacity */
+	int32 NumRecords;
+};
@@ -0,0 +1,107 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class FArchive;
+class FHurtboxCapsuleSet;
+
+/* Target hurtbox stored with single captured sample */
+struct FCapturedTarget
+{
+	/* Unique id of target actor */
+	uint32 TargetId;
+
+	/* Transform of target hurtbox mesh */
+	FTransform Transform;
+
+	/* Range of capsules of this target in FCapturedActivation capsule arrays */
+	int32 FirstCapsule;
+	int32 NumCapsules;
+};
+
+/* Socket locations and nearby targets at one trace check */
+struct FCapturedSample
+{
+	float Time;
+
+	/* Range of targets of this sample in FCapturedActivation::Targets, sockets start at sample index * NumSockets */
+	int32 FirstTarget;
+	int32 NumTargets;
+};
+
+/* All samples of single activation of single collision handler */
+struct FCapturedActivation
+{
+	uint32 HandlerId;
+	float TraceRadius;
+	int32 NumSockets;
+
+	TArray<FCapturedSample> Samples;
+
+	/* NumSockets locations per sample */
+	TArray<FVector> SocketLocations;
+
+	TArray<FCapturedTarget> Targets;
+
+	/* Capsules of all targets of all samples */
+	TArray<FVector> CapsuleStarts;
+	TArray<FVector> CapsuleEnds;
+	TArray<float> CapsuleRadii;
+
+	/* Returns socket location of given sample */
+	const FVector& GetSocketLocation(int32 SampleIndex, int32 SocketIndex) const { return SocketLocations[SampleIndex * NumSockets + SocketIndex]; }
+};
+
+/* Content of trajectory capture file */
+struct FCapturedTrajectories
+{
+	/* Activations in order in which they ended */
+	TArray<FCapturedActivation> Activations;
+
+	/* Bone names of capsules of every target, same order as capsules in samples */
+	TMap<uint32, TArray<FName>> TargetBoneNames;
+};
+
+/**
+ * Streaming writer of socket trajectories of collision handlers with bCaptureTrajectory set, owned by CollisionHandlerSubsystem.
+ * Every trace check appends socket locations as seen by UpdateSocketLocations and posed hurtbox capsules of nearby targets,
+ * so hit detection can be replayed offline without animation (see StarterBundleReplay commandlet).
+ * Records of several handlers are interleaved, every record carries id of its handler.
+ */
+class STARTERBUNDLE_API FCollisionTrajectoryWriter
+{
+public:
+	FCollisionTrajectoryWriter();
+	~FCollisionTrajectoryWriter();
+
+	/* Opens new file, closes previous one. Returns false if file couldn't be created */
+	bool Open(const FString& Filename);
+
+	/* Flushes and closes file */
+	void Close();
+
+	bool IsOpen() const { return Writer != nullptr; }
+
+	/* Starts activation of handler, following samples of handler belong to it */
+	void WriteActivationBegin(uint32 HandlerId, float TraceRadius, int32 NumSockets);
+
+	/* Starts sample of handler, must be followed by NumTargets calls of WriteTarget */
+	void WriteSampleBegin(uint32 HandlerId, float Time, const TArray<FVector>& SocketLocations, int32 NumTargets);
+
+	/* Writes target of current sample with its capsules from given range of capsule set */
+	void WriteTarget(uint32 TargetId, const FTransform& Transform, const FHurtboxCapsuleSet& Capsules, int32 FirstCapsule, int32 NumCapsules);
+
+	/* Ends activation of handler */
+	void WriteActivationEnd(uint32 HandlerId);
+
+	/* Reads file written by writer, activations which were not ended are dropped. Returns false if file is missing or has unknown format */
+	static bool LoadFromFile(const FString& Filename, FCapturedTrajectories& OutTrajectories);
+
+private:
+	FArchive* Writer;
+
+	/* Targets whose bone names were already written */
+	TSet<uint32> WrittenTargets;
+};
@@ -0,0 +1,66 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "CollisionTrajectoryCapture.h"
+
+/* Trace strategy used to replay captured trajectories */
+struct FCollisionReplaySettings
+{
+	FCollisionReplaySettings()
+		: TraceRadius(0.f), SampleStride(1), ArcSubsteps(1) {}
+
+	/* Radius of swept spheres, radius captured with activation is used if not positive */
+	float TraceRadius;
+
+	/* Only every n-th captured sample is used, emulates bigger TraceCheckInterval */
+	int32 SampleStride;
+
+	/* Number of sweeps the arc between two used samples is split into, 1 sweeps straight lines */
+	int32 ArcSubsteps;
+};
+
+/* First hit of target during replayed activation */
+struct FCollisionReplayHit
+{
+	int32 ActivationIndex;
+	int32 SampleIndex;
+	uint32 TargetId;
+	FName BoneName;
+
+	/* Point on axis of hit capsule closest to the sweep */
+	FVector ImpactPoint;
+};
+
+/* Output of single replay */
+struct FCollisionReplayResult
+{
+	FCollisionReplayResult()
+		: NumActivations(0), NumSamples(0), NumSweeps(0), Seconds(0.0) {}
+
+	int32 NumActivations;
+	int32 NumSamples;
+	int64 NumSweeps;
+
+	/* Time spent building sweeps and testing them against captured hurtboxes */
+	double Seconds;
+
+	/* Hits in order of activations and samples, every target is hit at most once per activation */
+	TArray<FCollisionReplayHit> Hits;
+};
+
+/**
+ * Replays socket trajectories captured by FCollisionTrajectoryWriter without animation, physics scene or live game.
+ * Sockets are swept against hurtbox capsules captured with every sample, using the same arc interpolation
+ * and capsule narrowphase as CollisionHandlerComponent, so trace strategies can be compared on saved real fights.
+ * Only socket sphere sweeps are modelled, every target is hit once per activation. Blade capsules, rehit policies
+ * and ignore rules of the component aren't replayed, since they need live actors, so use replay to compare sampling
+ * (stride, arc substeps, radius) rather than to predict exact hits of a configured component.
+ */
+class STARTERBUNDLE_API FCollisionTrajectoryReplay
+{
+public:
+	/* Replays all activations of trajectories with given settings */
+	static void Run(const FCapturedTrajectories& Trajectories, const FCollisionReplaySettings& Settings, FCollisionReplayResult& OutResult);
+};
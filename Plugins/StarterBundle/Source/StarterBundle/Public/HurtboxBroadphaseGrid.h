@@ -0,0 +1,96 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Two level uniform grid spatial hash of hurtbox owner bounds, rebuilt from scratch once per frame.
+ * Only occupied cells are stored, so memory and query cost depend on number and size of owners, not on world size.
+ * Large queries use coarse level, both levels are clamped to cells occupied by owners.
+ * Rebuilding and querying don't allocate once arrays have grown to the steady state.
+ * Queries only write stamps used to report every owner once, so they must not run concurrently.
+ */
+class STARTERBUNDLE_API FHurtboxBroadphaseGrid
+{
+public:
+	FHurtboxBroadphaseGrid();
+
+	/* Inserts every valid box into cells it overlaps, index of box in array is its owner index */
+	void Build(const TArray<FBox>& InOwnerBounds, float InCellSize);
+
+	/* Forgets all owners, keeps allocated memory */
+	void Reset();
+
+	/* Appends unique indices of owners whose cells overlap given bounds and whose bounds intersect them */
+	void Query(const FBox& QueryBounds, TArray<int32>& OutOwnerIndices) const;
+
+	/* Returns number of occupied cells */
+	int32 GetNumCells() const { return Cells.Num(); }
+
+	/* Returns edge length of single cell */
+	float GetCellSize() const { return FineLevel.CellSize; }
+
+private:
+	/* Owner stored in single cell */
+	struct FCellEntry
+	{
+		uint64 CellKey;
+		int32 OwnerIndex;
+
+		bool operator<(const FCellEntry& Other) const { return CellKey < Other.CellKey; }
+	};
+
+	/* Range of Entries belonging to single cell */
+	struct FCellRange
+	{
+		int32 First;
+		int32 Num;
+		FIntVector Cell;
+	};
+
+	/* Grid of single cell size */
+	struct FLevel
+	{
+		/* Entries of all cells, sorted by cell key */
+		TArray<FCellEntry> Entries;
+
+		/* Occupied cells */
+		TMap<uint64, FCellRange> Cells;
+
+		/* Range of cell coordinates occupied by owners */
+		FIntVector MinCell;
+		FIntVector MaxCell;
+
+		float CellSize;
+		float InvCellSize;
+
+		/* Returns coordinates of cell containing location */
+		FIntVector GetCell(const FVector& Location) const;
+	};
+
+	/* Inserts all valid owner bounds into level with given cell size */
+	void BuildLevel(FLevel& Level, float InCellSize);
+
+	/* Appends owners of all cells of level within given range of cells, tests every cell of the range or every occupied cell, whichever is fewer */
+	void QueryLevel(const FLevel& Level, const FIntVector& MinCell, const FIntVector& MaxCell, const FBox& QueryBounds, TArray<int32>& OutOwnerIndices) const;
+
+	/* Appends owners of single cell intersecting query bounds, which weren't reported by current query yet */
+	void QueryCell(const FLevel& Level, const FCellRange& Range, const FBox& QueryBounds, TArray<int32>& OutOwnerIndices) const;
+
+	/* Packs cell coordinates into single hash key, 21 bits per axis */
+	static uint64 MakeCellKey(int32 X, int32 Y, int32 Z);
+
+	/* Level with cell size passed to Build and level with cells several times bigger for large queries */
+	FLevel FineLevel;
+	FLevel CoarseLevel;
+
+	/* Bounds passed to Build, used for exact test of candidates */
+	TArray<FBox> OwnerBounds;
+
+	/* Stamp of last query which reported owner, per owner */
+	mutable TArray<uint32> OwnerQueryStamps;
+
+	/* Incremented by every query */
+	mutable uint32 QueryStamp;
+};
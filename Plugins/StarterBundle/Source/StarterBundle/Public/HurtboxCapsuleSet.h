@@ -0,0 +1,92 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/* Capsule hit by swept sphere, found by FHurtboxCapsuleSet::SweepSphere */
+struct FHurtboxCapsuleHit
+{
+	FHurtboxCapsuleHit() {}
+	FHurtboxCapsuleHit(int32 InCapsuleIndex, const FVector& InSweepLocation, const FVector& InCapsuleLocation)
+		: CapsuleIndex(InCapsuleIndex), SweepLocation(InSweepLocation), CapsuleLocation(InCapsuleLocation) {}
+
+	/* Index of capsule in the set */
+	int32 CapsuleIndex;
+
+	/* Point on swept segment closest to capsule axis */
+	FVector SweepLocation;
+
+	/* Point on capsule axis closest to swept segment */
+	FVector CapsuleLocation;
+};
+
+/**
+ * World space hurtbox capsules of all registered combatants stored as structure of arrays.
+ * Every capsule is a segment (Start, Start + Axis) with radius, spheres are stored as capsules with zero axis.
+ * Arrays are padded so that 4 floats can be loaded from any capsule, so SweepSphere tests 4 capsules per vector instruction
+ * starting at any capsule, which allows to test capsule ranges of single owners.
+ */
+class STARTERBUNDLE_API FHurtboxCapsuleSet
+{
+public:
+	FHurtboxCapsuleSet() : NumCapsules(0) {}
+
+	/* Forgets all capsules, keeps allocated memory */
+	void Reset();
+
+	/* Adds capsule between two points, returns its index */
+	int32 Add(const FVector& Start, const FVector& End, float Radius, int32 OwnerIndex, FName BoneName);
+
+	/* Returns number of capsules */
+	int32 Num() const { return NumCapsules; }
+
+	/* Returns index of owner passed to Add, owner indices are defined by whoever fills the set */
+	int32 GetOwnerIndex(int32 CapsuleIndex) const { return OwnerIndices[CapsuleIndex]; }
+
+	/* Returns name of bone capsule is attached to */
+	FName GetBoneName(int32 CapsuleIndex) const { return BoneNames[CapsuleIndex]; }
+
+	/* Returns radius of capsule */
+	float GetRadius(int32 CapsuleIndex) const { return Radii[CapsuleIndex]; }
+
+	/* Returns end points of capsule axis */
+	FVector GetStart(int32 CapsuleIndex) const;
+	FVector GetEnd(int32 CapsuleIndex) const;
+
+	/* Appends all capsules overlapped by sphere swept from Start to End, uses vectorized kernel */
+	void SweepSphere(const FVector& Start, const FVector& End, float SphereRadius, TArray<FHurtboxCapsuleHit>& OutHits) const;
+
+	/* Same as above, but tests only given range of capsules (e.g. capsules of broadphase candidate) */
+	void SweepSphere(const FVector& Start, const FVector& End, float SphereRadius, int32 FirstCapsule, int32 NumCapsulesToTest, TArray<FHurtboxCapsuleHit>& OutHits) const;
+
+	/* Same as SweepSphere, but tests capsules one by one with scalar math. Reference for vectorized kernel */
+	void SweepSphereScalar(const FVector& Start, const FVector& End, float SphereRadius, TArray<FHurtboxCapsuleHit>& OutHits) const;
+
+	/* Returns number of bytes allocated by set */
+	SIZE_T GetAllocatedSize() const;
+
+	/**
+	 * Returns squared distance between segments (P1, Q1) and (P2, Q2) and their closest points.
+	 * Same math as vectorized kernel, degenerate segments (points) are supported.
+	 */
+	static float SegmentDistSquared(const FVector& P1, const FVector& Q1, const FVector& P2, const FVector& Q2, FVector& OutClosest1, FVector& OutClosest2);
+
+private:
+	typedef TArray<float, TAlignedHeapAllocator<16>> FAlignedFloatArray;
+
+	/* Capsule axis start and axis vector, padded with zeros */
+	FAlignedFloatArray StartX;
+	FAlignedFloatArray StartY;
+	FAlignedFloatArray StartZ;
+	FAlignedFloatArray AxisX;
+	FAlignedFloatArray AxisY;
+	FAlignedFloatArray AxisZ;
+	FAlignedFloatArray Radii;
+
+	/* Per capsule data not used by kernel */
+	TArray<int32> OwnerIndices;
+	TArray<FName> BoneNames;
+
+	int32 NumCapsules;
+};
@@ -0,0 +1,69 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "HurtboxComponent.generated.h"
+
+class USkeletalMeshComponent;
+class FHurtboxCapsuleSet;
+
+/**
+ * Component which registers capsules and spheres of owner's physics asset as hurtboxes in CollisionHandlerSubsystem.
+ * Hurtboxes are tested by collision handlers with bUseHurtboxNarrowphase set instead of physics scene queries,
+ * so hit bone is known directly from the capsule. Place it on every character that can be hit by weapons.
+ */
+UCLASS( ClassGroup=(Custom), meta=(BlueprintSpawnableComponent) )
+class STARTERBUNDLE_API UHurtboxComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	// Sets default values for this component's properties
+	UHurtboxComponent();
+
+	/* Sets skeletal mesh whose physics asset bodies are used as hurtboxes and rebuilds capsules from its physics asset */
+	UFUNCTION(BlueprintCallable, Category = "CollisionHandler")
+	void SetHurtboxMesh(USkeletalMeshComponent* NewHurtboxMesh);
+
+	UFUNCTION(BlueprintCallable, Category = "CollisionHandler")
+	USkeletalMeshComponent* GetHurtboxMesh() const;
+
+	/* Bodies of these bones are not used as hurtboxes (e.g. weapon bones) */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CollisionHandler")
+	TArray<FName> IgnoredBones;
+
+	/* Appends world space capsules posed by current bone transforms of hurtbox mesh */
+	void AppendWorldCapsules(FHurtboxCapsuleSet& Capsules, int32 OwnerIndex) const;
+
+	/* Returns number of capsules built from physics asset */
+	int32 GetNumCapsules() const { return LocalCapsules.Num(); }
+
+protected:
+	// Called when the game starts
+	virtual void BeginPlay() override;
+
+	// Called when the game ends
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+private:
+	/* Capsule of physics asset body in space of its bone */
+	struct FLocalCapsule
+	{
+		int32 BoneIndex;
+		FName BoneName;
+		FVector Start;
+		FVector End;
+		float Radius;
+	};
+
+	/* Fills LocalCapsules with sphyl and sphere elements of hurtbox mesh physics asset */
+	void BuildLocalCapsules();
+
+	/* Mesh whose bone transforms pose the capsules, first skeletal mesh of owner by default */
+	UPROPERTY()
+	USkeletalMeshComponent* HurtboxMesh;
+
+	TArray<FLocalCapsule> LocalCapsules;
+};
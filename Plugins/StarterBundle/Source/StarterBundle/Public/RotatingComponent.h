@@ -14,10 +14,13 @@ DECLARE_MULTICAST_DELEGATE(FOnRotatingStartNative);
 DECLARE_DYNAMIC_MULTICAST_DELEGATE(FOnRotatingEnd);
 DECLARE_MULTICAST_DELEGATE(FOnRotatingEndNative);
 
+/* Native provider of desired rotation, called instead of RotatingComponentInterface if bound */
+DECLARE_DELEGATE_RetVal(FRotator, FGetDesiredRotationNative);
+
 /**
  * Component which allows to rotate character towards desired rotation which is defined in owning actor throught interface
  * Example of use: Rotate character towards input direction while it's playing attack anim montage with enabled root motion
- * Note! Owner of the component must implement RotatingComponentInterface
+ * Note! Owner of the component must implement RotatingComponentInterface, bind DesiredRotationProvider or push rotation through SetDesiredRotation
  */
 UCLASS( ClassGroup=(Custom), meta=(BlueprintSpawnableComponent) )
 class STARTERBUNDLE_API URotatingComponent : public UActorComponent
@@ -34,6 +37,16 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "RotatingComponent")
 	bool IsRotating() const;
 
+	/**
+	 * Whether rotation should be advanced by RotatingComponentSubsystem in one batched pass together with other rotating components.
+	 * If false component enables its own tick while rotating. In both cases nothing is ticked while component is not rotating.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "RotatingComponent")
+	uint32 bUseBatchedRotation : 1;
+
+	/* Native version of RotatingComponentInterface::GetDesiredRotation, skips Blueprint VM call when bound by native owner */
+	FGetDesiredRotationNative DesiredRotationProvider;
+
 	/* Delegate called when rotating has started */
 	UPROPERTY(BlueprintAssignable, Category = "RotatingComponent")
 	FOnRotatingStart OnRotatingStart;
@@ -60,10 +73,34 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "RotatingComponent")
 	void StopRotating();
 
+	/**
+	 * Sets rotation owner should be rotated at, call it only when desired rotation changes.
+	 * Until ClearDesiredRotation is called it is used instead of asking owner every tick.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "RotatingComponent")
+	void SetDesiredRotation(FRotator Rotation);
+
+	/* Goes back to asking owner for desired rotation every tick */
+	UFUNCTION(BlueprintCallable, Category = "RotatingComponent")
+	void ClearDesiredRotation();
+
+	/* Rotates owner towards desired rotation by given time, called by component tick or RotatingComponentSubsystem */
+	void UpdateRotation(float DeltaTime);
+
+	/* Returns rotating component of given actor without scanning its components, nullptr if actor has no registered rotating component */
+	static URotatingComponent* FindRotatingComponent(const AActor* Actor);
+
 protected:
 	// Called when the game starts
 	virtual void BeginPlay() override;
 
+	// Called when the game ends or component is destroyed
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	/* Adds and removes component from lookup used by FindRotatingComponent */
+	virtual void OnRegister() override;
+	virtual void OnUnregister() override;
+
 	/* Calls the rotating callbacks */
 	void NotifyOnRotatingStart();
 	void NotifyOnRotatingEnd();
@@ -81,4 +118,23 @@ private:
 
 	/* Time elapsed since rotating was activated */
 	float TimeElapsed;
+
+	/* Rotation set through SetDesiredRotation */
+	FRotator PushedDesiredRotation;
+
+	/* Whether PushedDesiredRotation should be used instead of asking owner */
+	uint32 bHasPushedDesiredRotation : 1;
+
+	/* Whether owner implements RotatingComponentInterface, cached at BeginPlay */
+	uint32 bOwnerImplementsInterface : 1;
+
+	/* Retrieves desired rotation from pushed value, native provider or owner interface, returns false if none is available */
+	bool GetDesiredRotation(AActor* Owner, FRotator& OutDesiredRotation) const;
+
+	/* Whether rotation is currently advanced by RotatingComponentSubsystem instead of tick */
+	uint32 bIsRegisteredInSubsystem : 1;
+
+	/* Enables tick or registers in subsystem while rotating, disables both when rotating ends */
+	void StartUpdatingRotation();
+	void StopUpdatingRotation();
 };
@@ -0,0 +1,51 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "RotatingComponentSubsystem.generated.h"
+
+class URotatingComponent;
+
+/**
+ * World subsystem which advances every currently rotating component in one batched pass per frame.
+ * Used instead of component ticks when URotatingComponent::bUseBatchedRotation is set.
+ */
+UCLASS()
+class STARTERBUNDLE_API URotatingComponentSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	/* overridden USubsystem functions */
+	virtual void Deinitialize() override;
+
+	/* overridden FTickableGameObject functions */
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual TStatId GetStatId() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override;
+
+	/* Adds component to the batched pass, does nothing if it is already registered */
+	void RegisterComponent(URotatingComponent* Component);
+
+	/* Removes component from the batched pass, safe to call during the pass (e.g. when rotating ends) */
+	void UnregisterComponent(URotatingComponent* Component);
+
+	/* Returns number of components currently processed by the batched pass */
+	UFUNCTION(BlueprintCallable, Category = "RotatingComponent")
+	int32 GetNumRotatingComponents() const;
+
+private:
+	/* Currently rotating components, processed in order of registration */
+	UPROPERTY()
+	TArray<URotatingComponent*> RotatingComponents;
+
+	/* Whether components are currently being processed, removals are deferred until the pass ends */
+	uint32 bIsProcessingComponents : 1;
+
+	/* Whether any component was unregistered during the pass and its slot has to be compacted */
+	uint32 bHasPendingRemovals : 1;
+};
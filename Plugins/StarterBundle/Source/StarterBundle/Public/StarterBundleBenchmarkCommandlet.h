@@ -0,0 +1,101 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "StarterBundleBenchmarkCommandlet.generated.h"
+
+class UAnimMontage;
+class USkeletalMesh;
+
+/* Settings varied between benchmark runs, the rest of options is shared by all runs */
+struct FStarterBundleBenchmarkSettings
+{
+	int32 NumActors;
+	int32 NumTraceWorkers;
+	bool bUseBatching;
+
+	/* Trace check interval of handlers, 0 keeps default of the component */
+	float TraceCheckInterval;
+
+	/* Whether run is reference of missed hits, with straight sweeps at fixed interval */
+	bool bIsReference;
+};
+
+/* Result of single benchmark run with given settings */
+struct FStarterBundleBenchmarkResult
+{
+	FStarterBundleBenchmarkSettings Settings;
+	int32 NumFrames;
+	double GameThreadMsPerFrame;
+	double SweepsPerSecond;
+	int64 NumSweeps;
+	int64 NumHits;
+	int64 NumTraceLoopAllocations;
+
+	/* Hits of whole run (warmup included) as attacker, activation of attacker and victim, compared with hits of reference run */
+	TSet<uint64> HitKeys;
+};
+
+/**
+ * Headless benchmark of CollisionHandlerComponent and RotatingComponent, runs without rendering (e.g. with -nullrhi on Linux).
+ * Spawns N actors playing attack montage with collision handler and rotating component, ticks the world with fixed delta time
+ * and reports game thread ms per frame, sweeps per second and hit counts for every N (and every number of trace workers) as CSV.
+ *
+ * Example: UE4Editor-Cmd ProjectForPlugins -run=StarterBundleBenchmark -nullrhi -Counts=25,50,100,200 -Frames=600 -Output=Bench.csv
+ * Options:
+ *   -Counts=       comma separated numbers of actors, default 25,50,100,200
+ *   -Frames=       measured frames per run, default 600
+ *   -WarmupFrames= frames ticked before measuring, default 60
+ *   -Fps=          fixed tick rate of the world, default 60
+ *   -Mesh=         skeletal mesh of actors, default mannequin
+ *   -Montage=      attack montage looped by actors, default 1HS_Attack_02_Montage
+ *   -Sockets=      comma separated collision sockets or bones, default hand_r,lowerarm_r
+ *   -Output=       CSV file, default Saved/Benchmarks/StarterBundleBenchmark.csv
+ *   -NoBatching    use per-component timers instead of CollisionHandlerSubsystem
+ *   -CompareBatching run every count both with per-component timers and with CollisionHandlerSubsystem, overrides -NoBatching
+ *   -Intervals=    comma separated trace check intervals, every count is run with each of them and hits missing compared
+ *                  with reference run at -ReferenceInterval= (default 1/120 s, straight sweeps) are reported as MissedHits
+ *   -InterpolateArc rebuild socket arcs between samples, use with -Intervals= to compare missed hits with straight sweeps
+ *   -ArcSubsteps=  sweeps per arc with -InterpolateArc, default of the component
+ *   -Async         use async sweeps
+ *   -Narrowphase   test sweeps against HurtboxComponent capsules instead of physics scene, compare with run without it
+ *   -Broadphase    skip trace checks of handlers with no HurtboxComponent nearby, use with -Counts=1000 to check scaling
+ *   -CheckAllocations count heap allocations of trace checks after warmup on any thread, fails with exit code 1 if there are any
+ *   -AdaptiveError= max distance error in cm of adaptive trace interval, compare sweeps per second with run without it
+ *   -TraceWorkers= comma separated numbers of threads sweeping batched handlers, e.g. 1,2,4,8 for scaling curve, default 0 (not deferred)
+ *
+ * Microbenchmarks measure single code path in a loop and replace the runs above:
+ *   -Micro=        comma separated microbenchmarks:
+ *                  Sockets  socket locations by name into TMap (trace loop before sockets were resolved) vs resolved bindings into flat arrays,
+ *                           every pass samples all sockets of all actors, reported per socket sample
+ *                  Notifies handler lookup by GetComponentByClass vs owner-keyed registry, and NotifyBegin/NotifyEnd pair of ActivateCollisionNotifyState
+ *   -MicroActors=  posed actors, default 200
+ *   -MicroSockets= sockets per actor, -Sockets= topped up with bones of the mesh, default 8
+ *   -MicroComponents= extra scene components of every actor scanned by GetComponentByClass, default 8
+ *   -MicroIterations= iterations of every variant, Sockets makes MicroIterations / MicroActors passes, default 100000
+ *   -MicroOutput=  CSV file, default Saved/Benchmarks/StarterBundleMicro.csv
+ */
+UCLASS()
+class STARTERBUNDLE_API UStarterBundleBenchmarkCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	/* constructor */
+	UStarterBundleBenchmarkCommandlet();
+
+	/* overridden UCommandlet function */
+	virtual int32 Main(const FString& Params) override;
+
+private:
+	/* Runs single benchmark with given settings in new world */
+	FStarterBundleBenchmarkResult RunBenchmark(const FStarterBundleBenchmarkSettings& Settings, const FString& Params, USkeletalMesh* Mesh, UAnimMontage* Montage, const TArray<FName>& Sockets);
+
+	/* Runs microbenchmarks listed in MicroValue in new world, returns exit code */
+	int32 RunMicrobenchmarks(const FString& MicroValue, const FString& Params, USkeletalMesh* Mesh, UAnimMontage* Montage, const TArray<FName>& Sockets);
+
+	/* Returns whether montage contains ActivateCollisionNotifyState windows */
+	static bool HasCollisionWindows(const UAnimMontage* Montage);
+};
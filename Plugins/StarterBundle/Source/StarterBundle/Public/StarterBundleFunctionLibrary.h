@@ -6,6 +6,9 @@
 #include "Kismet/BlueprintFunctionLibrary.h"
 #include "StarterBundleFunctionLibrary.generated.h"
 
+class UAnimMontage;
+class USkeletalMesh;
+
 /**
  * 
  */
@@ -13,5 +16,15 @@ UCLASS()
 class STARTERBUNDLE_API UStarterBundleFunctionLibrary : public UBlueprintFunctionLibrary
 {
 	GENERATED_BODY()
-	
+
+public:
+#if WITH_EDITOR
+	/**
+	 * Bakes locations of given sockets of Mesh over every ActivateCollisionNotifyState window of Montage and stores them with the montage.
+	 * Collision handlers with bUseBakedTrajectories set read baked locations instead of evaluating the pose. Has to be run again
+	 * whenever montage, its notifies or sockets change. Returns false if nothing could be baked.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "CollisionHandler", meta = (DevelopmentOnly))
+	static bool BakeSocketTrajectories(UAnimMontage* Montage, USkeletalMesh* Mesh, const TArray<FName>& Sockets, float SampleRate = 60.f);
+#endif
 };
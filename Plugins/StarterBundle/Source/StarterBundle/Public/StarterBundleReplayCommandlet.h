@@ -0,0 +1,35 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "StarterBundleReplayCommandlet.generated.h"
+
+/**
+ * Replays trajectory file captured by collision handlers with bCaptureTrajectory set, without loading maps or animations.
+ * Reports sweeps, hits and time of given trace strategy and writes hits as CSV. If baseline CSV is given,
+ * fails with exit code 1 when hits differ, so trace strategy changes can be regression-tested on saved real fights.
+ *
+ * Example: UE4Editor-Cmd ProjectForPlugins -run=StarterBundleReplay -File=Saved/CollisionTrajectories/Arena.sbtraj -Stride=2 -ArcSubsteps=3
+ * Options:
+ *   -File=        captured trajectory file, required
+ *   -Radius=      radius of swept spheres, default radius captured with every activation
+ *   -Stride=      use only every n-th sample, default 1
+ *   -ArcSubsteps= sweeps per arc between two used samples, default 1 (straight sweeps)
+ *   -Iterations=  how many times replay is repeated for timing, default 1
+ *   -Output=      hits CSV, default Saved/Benchmarks/StarterBundleReplay.csv
+ *   -Baseline=    hits CSV of previous run to compare with
+ */
+UCLASS()
+class STARTERBUNDLE_API UStarterBundleReplayCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	/* constructor */
+	UStarterBundleReplayCommandlet();
+
+	/* overridden UCommandlet function */
+	virtual int32 Main(const FString& Params) override;
+};